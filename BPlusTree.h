@@ -0,0 +1,474 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "RecordFile.h"
+
+using namespace std;
+
+// ON-DISK B+ TREE
+// Paged primary-key index: fixed-size pages of BPTREE_PAGE_BYTES, zero-padded keys of
+// up to BPTREE_KEY_BYTES (IDs are at most 15 chars) and 64-bit values. Pages are read
+// and written through recordBufferPool, so a lookup touches O(log_B n) pages and
+// opening the tree only reads its header.
+//
+// File layout:
+//   page 0: header (magic, clean flag, root, page count, height, entry count, fingerprint)
+//   leaf:   leaf=1 (u16) | count (u16) | next leaf (u32) | count x (key | value i64)
+//   inner:  leaf=0 (u16) | count (u16) | unused (u32) | child0 (u32) | count x (key | child u32)
+// Inner key i is the smallest key under child i + 1. Deletes only remove the entry from
+// its leaf; the space comes back when the tree is rebuilt by bulkLoad (compaction).
+//
+// The clean flag is cleared on disk before the first change and set again by close(),
+// together with a fingerprint of the files the tree mirrors, so a tree left behind by a
+// crash (or next to different base files) is never trusted.
+
+const uint32_t BPTREE_MAGIC = 0x31545042; // "BPT1"
+const size_t BPTREE_PAGE_BYTES = BUFFER_POOL_PAGE_BYTES;
+const size_t BPTREE_KEY_BYTES = 16;
+const double BPTREE_BULK_FILL = 0.9; // Leaves bulkLoad leaves room in for later inserts
+
+class BPlusTree {
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t clean;
+        uint32_t root;      // 0 when the tree is empty
+        uint32_t pageCount;
+        uint32_t height;    // 1 = the root is a leaf
+        uint32_t keyBytes;
+        uint64_t entries;
+        uint64_t fingerprint[3];
+    };
+
+    static const size_t NODE_HEADER = 8;
+    static const size_t LEAF_SLOT = BPTREE_KEY_BYTES + sizeof(int64_t);
+    static const size_t INNER_SLOT = BPTREE_KEY_BYTES + sizeof(uint32_t);
+    static const size_t LEAF_CAPACITY = (BPTREE_PAGE_BYTES - NODE_HEADER) / LEAF_SLOT;
+    static const size_t INNER_CAPACITY = (BPTREE_PAGE_BYTES - NODE_HEADER - sizeof(uint32_t)) / INNER_SLOT;
+    static const size_t BULK_WRITE_PAGES = 256;
+
+    string path;
+    int fd;
+    Header header;
+    bool stale; // A key did not fit, so the tree no longer mirrors the index
+
+    // --- Page layout helpers ---
+    static uint16_t u16At(const char* p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    static uint32_t u32At(const char* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    static void setU16(char* p, uint16_t v) { memcpy(p, &v, sizeof(v)); }
+    static void setU32(char* p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+
+    static size_t countOf(const char* page) { return u16At(page + 2); }
+    static uint32_t nextLeaf(const char* page) { return u32At(page + 4); }
+    static void setNode(char* page, bool leaf, size_t count, uint32_t next) {
+        setU16(page, leaf ? 1 : 0);
+        setU16(page + 2, (uint16_t)count);
+        setU32(page + 4, next);
+    }
+
+    static char* leafSlot(char* page, size_t i) { return page + NODE_HEADER + i * LEAF_SLOT; }
+    static const char* leafSlot(const char* page, size_t i) { return page + NODE_HEADER + i * LEAF_SLOT; }
+    static int64_t leafValue(const char* page, size_t i) {
+        int64_t v;
+        memcpy(&v, leafSlot(page, i) + BPTREE_KEY_BYTES, sizeof(v));
+        return v;
+    }
+
+    // Child i sits just before key i; child 0 has no key of its own.
+    static const char* innerKey(const char* page, size_t i) {
+        return page + NODE_HEADER + sizeof(uint32_t) + i * INNER_SLOT;
+    }
+    static uint32_t innerChild(const char* page, size_t i) {
+        return i == 0 ? u32At(page + NODE_HEADER) : u32At(innerKey(page, i - 1) + BPTREE_KEY_BYTES);
+    }
+
+    // Index of the first leaf key >= key.
+    static size_t leafLowerBound(const char* page, const char* key) {
+        size_t lo = 0, hi = countOf(page);
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (memcmp(leafSlot(page, mid), key, BPTREE_KEY_BYTES) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Index of the first inner key > key, which is also the child to descend into.
+    static size_t innerUpperBound(const char* page, const char* key) {
+        size_t lo = 0, hi = countOf(page);
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (memcmp(innerKey(page, mid), key, BPTREE_KEY_BYTES) <= 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Zero-pads key into out. Returns false if it is too long to store.
+    static bool encodeKey(string_view key, char* out) {
+        if (key.size() > BPTREE_KEY_BYTES) return false;
+        memset(out, 0, BPTREE_KEY_BYTES);
+        memcpy(out, key.data(), key.size());
+        return true;
+    }
+
+    // --- Page access ---
+    // The pointer is only valid until the next page is loaded or allocated.
+    char* page(uint32_t pageNo) {
+        if (char* p = recordBufferPool.find(fd, pageNo)) return p;
+        int64_t start = (int64_t)pageNo * (int64_t)BPTREE_PAGE_BYTES;
+        char* p = recordBufferPool.insert(fd, pageNo, BPTREE_PAGE_BYTES, start, BPTREE_PAGE_BYTES);
+        preadFully(fd, p, BPTREE_PAGE_BYTES, start); // Short reads leave the tail zeroed
+        return p;
+    }
+
+    uint32_t allocPage() {
+        uint32_t pageNo = header.pageCount++;
+        recordBufferPool.insert(fd, pageNo, BPTREE_PAGE_BYTES, (int64_t)pageNo * (int64_t)BPTREE_PAGE_BYTES, BPTREE_PAGE_BYTES);
+        recordBufferPool.markDirty(fd, pageNo);
+        return pageNo;
+    }
+
+    void touch(uint32_t pageNo) { recordBufferPool.markDirty(fd, pageNo); }
+
+    void writeHeader() {
+        char buf[BPTREE_PAGE_BYTES] = {};
+        memcpy(buf, &header, sizeof(header));
+        if (!pwriteFully(fd, buf, BPTREE_PAGE_BYTES, 0)) {
+            throw runtime_error("Failed to write B+ tree header " + path);
+        }
+    }
+
+    void resetHeader() {
+        memset(&header, 0, sizeof(header));
+        header.magic = BPTREE_MAGIC;
+        header.pageCount = 1;
+        header.keyBytes = BPTREE_KEY_BYTES;
+    }
+
+    // Marks the on-disk tree as not trustworthy until the next clean close.
+    void beginWrite() {
+        if (!header.clean) return;
+        header.clean = 0;
+        writeHeader();
+        syncDataFd(fd);
+    }
+
+    // Inserts separator/child into the parents on path after a split of the node below.
+    void insertIntoParents(vector<uint32_t>& path, char* sep, uint32_t newChild) {
+        while (!path.empty()) {
+            uint32_t parentNo = path.back();
+            path.pop_back();
+            char* parent = page(parentNo);
+            size_t count = countOf(parent);
+            size_t pos = innerUpperBound(parent, sep);
+
+            if (count < INNER_CAPACITY) {
+                char* slot = const_cast<char*>(innerKey(parent, pos));
+                memmove(slot + INNER_SLOT, slot, (count - pos) * INNER_SLOT);
+                memcpy(slot, sep, BPTREE_KEY_BYTES);
+                setU32(slot + BPTREE_KEY_BYTES, newChild);
+                setU16(parent + 2, (uint16_t)(count + 1));
+                touch(parentNo);
+                return;
+            }
+
+            // Split the inner node: gather count + 1 keys and count + 2 children
+            vector<char> keys((count + 1) * BPTREE_KEY_BYTES);
+            vector<uint32_t> children(count + 2);
+            for (size_t i = 0, k = 0; i <= count; i++) {
+                if (i == pos) {
+                    memcpy(&keys[k * BPTREE_KEY_BYTES], sep, BPTREE_KEY_BYTES);
+                    k++;
+                }
+                if (i < count) {
+                    memcpy(&keys[k * BPTREE_KEY_BYTES], innerKey(parent, i), BPTREE_KEY_BYTES);
+                    k++;
+                }
+            }
+            for (size_t i = 0, c = 0; i <= count; i++) {
+                children[c++] = innerChild(parent, i);
+                if (i == pos) children[c++] = newChild;
+            }
+
+            size_t leftKeys = (count + 1) / 2;
+            size_t rightKeys = count - leftKeys; // One key moves up
+            writeInner(parent, &keys[0], &children[0], leftKeys);
+            touch(parentNo);
+
+            uint32_t rightNo = allocPage();
+            writeInner(page(rightNo), &keys[(leftKeys + 1) * BPTREE_KEY_BYTES], &children[leftKeys + 1], rightKeys);
+            memcpy(sep, &keys[leftKeys * BPTREE_KEY_BYTES], BPTREE_KEY_BYTES);
+            newChild = rightNo;
+        }
+
+        // The root split: grow the tree by one level
+        uint32_t rootNo = allocPage();
+        uint32_t children[2] = {header.root, newChild};
+        writeInner(page(rootNo), sep, children, 1);
+        header.root = rootNo;
+        header.height++;
+    }
+
+    static void writeInner(char* p, const char* keys, const uint32_t* children, size_t count) {
+        setNode(p, false, count, 0);
+        setU32(p + NODE_HEADER, children[0]);
+        for (size_t i = 0; i < count; i++) {
+            char* slot = const_cast<char*>(innerKey(p, i));
+            memcpy(slot, keys + i * BPTREE_KEY_BYTES, BPTREE_KEY_BYTES);
+            setU32(slot + BPTREE_KEY_BYTES, children[i + 1]);
+        }
+    }
+
+public:
+    explicit BPlusTree(const string& treePath) : path(treePath), fd(-1), stale(false) {
+        resetHeader();
+    }
+
+    ~BPlusTree() {
+        if (fd != -1) {
+            recordBufferPool.dropFile(fd);
+            closeDataFd(fd);
+        }
+    }
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    // Opens (or creates) the tree file. Returns true if it was closed cleanly while
+    // mirroring files with the given fingerprint, i.e. it can serve lookups as is.
+    bool open(const uint64_t fingerprint[3]) {
+        fd = openDataFd(path);
+        if (fd == -1) throw runtime_error("Cannot open B+ tree " + path);
+
+        Header onDisk;
+        bool valid = dataFdSize(fd) >= (int64_t)BPTREE_PAGE_BYTES &&
+                     preadFully(fd, &onDisk, sizeof(onDisk), 0) == sizeof(onDisk) &&
+                     onDisk.magic == BPTREE_MAGIC && onDisk.keyBytes == BPTREE_KEY_BYTES;
+        if (!valid) return false;
+        header = onDisk;
+        return header.clean && memcmp(header.fingerprint, fingerprint, sizeof(header.fingerprint)) == 0;
+    }
+
+    // Flushes every page and marks the tree clean for the given fingerprint.
+    void close(const uint64_t fingerprint[3]) {
+        if (fd == -1) return;
+        recordBufferPool.dropFile(fd);
+        if (!stale) {
+            syncDataFd(fd);
+            header.clean = 1;
+            memcpy(header.fingerprint, fingerprint, sizeof(header.fingerprint));
+            writeHeader();
+            syncDataFd(fd);
+        }
+        closeDataFd(fd);
+        fd = -1;
+    }
+
+    bool find(string_view key, int64_t& value) {
+        char k[BPTREE_KEY_BYTES];
+        if (!header.root || !encodeKey(key, k)) return false;
+
+        uint32_t pageNo = header.root;
+        for (uint32_t level = 1; level < header.height; level++) {
+            const char* p = page(pageNo);
+            pageNo = innerChild(p, innerUpperBound(p, k));
+        }
+        const char* leaf = page(pageNo);
+        size_t i = leafLowerBound(leaf, k);
+        if (i < countOf(leaf) && memcmp(leafSlot(leaf, i), k, BPTREE_KEY_BYTES) == 0) {
+            value = leafValue(leaf, i);
+            return true;
+        }
+        return false;
+    }
+
+    // Inserts key, or overwrites its value if it is already present.
+    void insert(string_view key, int64_t value) {
+        char k[BPTREE_KEY_BYTES];
+        if (!encodeKey(key, k)) {
+            stale = true;
+            return;
+        }
+        beginWrite();
+
+        if (!header.root) {
+            header.root = allocPage();
+            header.height = 1;
+            char* leaf = page(header.root);
+            setNode(leaf, true, 1, 0);
+            memcpy(leafSlot(leaf, 0), k, BPTREE_KEY_BYTES);
+            memcpy(leafSlot(leaf, 0) + BPTREE_KEY_BYTES, &value, sizeof(value));
+            header.entries = 1;
+            return;
+        }
+
+        vector<uint32_t> path;
+        uint32_t leafNo = header.root;
+        for (uint32_t level = 1; level < header.height; level++) {
+            path.push_back(leafNo);
+            const char* p = page(leafNo);
+            leafNo = innerChild(p, innerUpperBound(p, k));
+        }
+
+        char* leaf = page(leafNo);
+        size_t count = countOf(leaf);
+        size_t pos = leafLowerBound(leaf, k);
+        if (pos < count && memcmp(leafSlot(leaf, pos), k, BPTREE_KEY_BYTES) == 0) {
+            memcpy(leafSlot(leaf, pos) + BPTREE_KEY_BYTES, &value, sizeof(value));
+            touch(leafNo);
+            return;
+        }
+        header.entries++;
+
+        if (count < LEAF_CAPACITY) {
+            memmove(leafSlot(leaf, pos + 1), leafSlot(leaf, pos), (count - pos) * LEAF_SLOT);
+            memcpy(leafSlot(leaf, pos), k, BPTREE_KEY_BYTES);
+            memcpy(leafSlot(leaf, pos) + BPTREE_KEY_BYTES, &value, sizeof(value));
+            setU16(leaf + 2, (uint16_t)(count + 1));
+            touch(leafNo);
+            return;
+        }
+
+        // Split the full leaf: stage count + 1 entries, keep the lower half in place
+        vector<char> slots((count + 1) * LEAF_SLOT);
+        memcpy(&slots[0], leafSlot(leaf, 0), pos * LEAF_SLOT);
+        memcpy(&slots[pos * LEAF_SLOT], k, BPTREE_KEY_BYTES);
+        memcpy(&slots[pos * LEAF_SLOT + BPTREE_KEY_BYTES], &value, sizeof(value));
+        memcpy(&slots[(pos + 1) * LEAF_SLOT], leafSlot(leaf, pos), (count - pos) * LEAF_SLOT);
+        uint32_t oldNext = nextLeaf(leaf);
+
+        size_t leftCount = (count + 1) / 2;
+        size_t rightCount = count + 1 - leftCount;
+        uint32_t rightNo = allocPage();
+        char* right = page(rightNo);
+        setNode(right, true, rightCount, oldNext);
+        memcpy(leafSlot(right, 0), &slots[leftCount * LEAF_SLOT], rightCount * LEAF_SLOT);
+
+        leaf = page(leafNo);
+        setNode(leaf, true, leftCount, rightNo);
+        memcpy(leafSlot(leaf, 0), &slots[0], leftCount * LEAF_SLOT);
+        touch(leafNo);
+
+        char sep[BPTREE_KEY_BYTES];
+        memcpy(sep, &slots[leftCount * LEAF_SLOT], BPTREE_KEY_BYTES);
+        insertIntoParents(path, sep, rightNo);
+    }
+
+    // Removes key from its leaf. Returns false if it was not present.
+    bool erase(string_view key) {
+        char k[BPTREE_KEY_BYTES];
+        if (!header.root || !encodeKey(key, k)) return false;
+
+        uint32_t leafNo = header.root;
+        for (uint32_t level = 1; level < header.height; level++) {
+            const char* p = page(leafNo);
+            leafNo = innerChild(p, innerUpperBound(p, k));
+        }
+        char* leaf = page(leafNo);
+        size_t count = countOf(leaf);
+        size_t pos = leafLowerBound(leaf, k);
+        if (pos == count || memcmp(leafSlot(leaf, pos), k, BPTREE_KEY_BYTES) != 0) return false;
+
+        beginWrite();
+        leaf = page(leafNo);
+        memmove(leafSlot(leaf, pos), leafSlot(leaf, pos + 1), (count - pos - 1) * LEAF_SLOT);
+        setU16(leaf + 2, (uint16_t)(count - 1));
+        touch(leafNo);
+        header.entries--;
+        return true;
+    }
+
+    // Rebuilds the tree bottom-up from entries sorted by key, writing every page once.
+    // keyOf / valueOf extract the key string and value of one entry.
+    template <class Entries, class KeyOf, class ValueOf>
+    void bulkLoad(const Entries& entries, KeyOf keyOf, ValueOf valueOf) {
+        beginWrite();
+        recordBufferPool.dropFile(fd);
+        truncateDataFd(fd, (int64_t)BPTREE_PAGE_BYTES);
+        resetHeader();
+        stale = false;
+
+        // First key and page number of every node on the level being built
+        vector<char> levelKeys;
+        vector<uint32_t> levelPages;
+        vector<char> batch;
+        uint32_t batchStart = header.pageCount;
+        auto emit = [&](const char* p) {
+            batch.insert(batch.end(), p, p + BPTREE_PAGE_BYTES);
+            header.pageCount++;
+            if (batch.size() >= BULK_WRITE_PAGES * BPTREE_PAGE_BYTES) {
+                pwriteFully(fd, batch.data(), batch.size(), (int64_t)batchStart * (int64_t)BPTREE_PAGE_BYTES);
+                batch.clear();
+                batchStart = header.pageCount;
+            }
+        };
+
+        size_t leafFill = max<size_t>(1, (size_t)(LEAF_CAPACITY * BPTREE_BULK_FILL));
+        char p[BPTREE_PAGE_BYTES];
+        char k[BPTREE_KEY_BYTES];
+        size_t count = 0;
+        for (const auto& e : entries) {
+            if (!encodeKey(keyOf(e), k)) {
+                stale = true;
+                continue;
+            }
+            if (count == leafFill) {
+                // Leaves are written in key order, so the next one is the next page
+                setNode(p, true, count, header.pageCount + 1);
+                emit(p);
+                count = 0;
+            }
+            if (count == 0) {
+                memset(p, 0, sizeof(p));
+                levelKeys.insert(levelKeys.end(), k, k + BPTREE_KEY_BYTES);
+                levelPages.push_back(header.pageCount);
+            }
+            int64_t value = valueOf(e);
+            memcpy(leafSlot(p, count), k, BPTREE_KEY_BYTES);
+            memcpy(leafSlot(p, count) + BPTREE_KEY_BYTES, &value, sizeof(value));
+            header.entries++;
+            count++;
+        }
+        if (count) {
+            setNode(p, true, count, 0);
+            emit(p);
+        }
+
+        header.height = levelPages.empty() ? 0 : 1;
+        size_t innerFill = max<size_t>(2, (size_t)(INNER_CAPACITY * BPTREE_BULK_FILL));
+        while (levelPages.size() > 1) {
+            vector<char> upperKeys;
+            vector<uint32_t> upperPages;
+            for (size_t first = 0; first < levelPages.size(); first += innerFill + 1) {
+                size_t children = min(innerFill + 1, levelPages.size() - first);
+                memset(p, 0, sizeof(p));
+                writeInner(p, &levelKeys[(first + 1) * BPTREE_KEY_BYTES], &levelPages[first], children - 1);
+                upperKeys.insert(upperKeys.end(), &levelKeys[first * BPTREE_KEY_BYTES], &levelKeys[(first + 1) * BPTREE_KEY_BYTES]);
+                upperPages.push_back(header.pageCount);
+                emit(p);
+            }
+            levelKeys.swap(upperKeys);
+            levelPages.swap(upperPages);
+            header.height++;
+        }
+        if (!batch.empty()) {
+            pwriteFully(fd, batch.data(), batch.size(), (int64_t)batchStart * (int64_t)BPTREE_PAGE_BYTES);
+        }
+        header.root = levelPages.empty() ? 0 : levelPages[0];
+        writeHeader();
+    }
+
+    uint64_t size() const { return header.entries; }
+    uint32_t height() const { return header.height; }
+    uint32_t pages() const { return header.pageCount; }
+};
+
+#endif
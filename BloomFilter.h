@@ -0,0 +1,162 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+// BLOOM FILTER
+// Sits in front of a primary index so lookups of IDs that were never inserted (the
+// duplicate checks in addAppointment / AddDoctor, queries for missing IDs) are answered
+// without searching. BLOOM_BITS_PER_KEY bits and BLOOM_HASHES probes per key give about
+// a 1% false-positive rate at capacity. Probes use double hashing over one 64-bit hash.
+//
+// Bits cannot be cleared, so deletes only raise the false-positive rate; the owner
+// rebuilds the filter from its index once needsRebuild() says it has drifted too far.
+//
+// Saved at shutdown with the fingerprint of the index files it was built for, and
+// removed once loaded, so a filter left behind by a crash is never trusted.
+
+const uint32_t BLOOM_MAGIC = 0x314D4C42; // "BLM1"
+const size_t BLOOM_BITS_PER_KEY = 10;
+const uint32_t BLOOM_HASHES = 7;
+const size_t BLOOM_MIN_KEYS = 1024;
+
+class BloomFilter {
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t hashes;
+        uint64_t words;
+        uint64_t capacity;
+        uint64_t keys;
+        uint64_t deletes;
+        uint64_t fingerprint[3];
+    };
+
+    vector<uint64_t> bits;
+    size_t capacity = 0; // Keys the filter was sized for
+    size_t keys = 0;     // Keys added since it was built
+    size_t deletes = 0;  // Keys removed since it was built
+
+    // Lookup counters for printStats (this run only)
+    size_t probes = 0;
+    size_t skipped = 0;        // Definite misses
+    size_t falsePositives = 0; // Passed the filter, then missed in the index
+
+    static uint64_t hashKey(string_view key) {
+        uint64_t h = 14695981039346656037ull; // FNV-1a
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        // Final mix so the high and low halves are independent enough for double hashing
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+public:
+    bool built() const { return !bits.empty(); }
+
+    // Sizes the filter for n keys (with room to grow) and adds keyOf(e) for each entry.
+    template <class Range, class KeyOf>
+    void build(const Range& entries, size_t n, KeyOf keyOf) {
+        capacity = max(BLOOM_MIN_KEYS, n + n / 2);
+        size_t words = 1;
+        while (words * 64 < capacity * BLOOM_BITS_PER_KEY) words <<= 1;
+        bits.assign(words, 0);
+        keys = deletes = 0;
+        for (const auto& e : entries) add(keyOf(e));
+    }
+
+    void add(string_view key) {
+        if (bits.empty()) return;
+        uint64_t h = hashKey(key);
+        uint64_t step = (h >> 32) | 1;
+        uint64_t mask = bits.size() * 64 - 1;
+        for (uint32_t i = 0; i < BLOOM_HASHES; i++, h += step) {
+            bits[(h & mask) >> 6] |= 1ull << (h & 63);
+        }
+        keys++;
+    }
+    void noteErase() { deletes++; }
+
+    // Past capacity the false-positive rate climbs quickly; stale bits from deletes do the same.
+    bool needsRebuild() const { return keys > capacity || deletes > capacity / 2; }
+
+    // False means key was never added. Always true while the filter is not built.
+    bool mayContain(string_view key) {
+        if (bits.empty()) return true;
+        probes++;
+        uint64_t h = hashKey(key);
+        uint64_t step = (h >> 32) | 1;
+        uint64_t mask = bits.size() * 64 - 1;
+        for (uint32_t i = 0; i < BLOOM_HASHES; i++, h += step) {
+            if (!(bits[(h & mask) >> 6] & (1ull << (h & 63)))) {
+                skipped++;
+                return false;
+            }
+        }
+        return true;
+    }
+    void countFalsePositive() { falsePositives++; }
+
+    // Loads a filter saved for the given fingerprint, then removes the file.
+    bool load(const string& path, const uint64_t fingerprint[3]) {
+        Header header;
+        ifstream in(path, ios::binary);
+        bool ok = in.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.magic == BLOOM_MAGIC &&
+                  header.hashes == BLOOM_HASHES && header.words > 0 && (header.words & (header.words - 1)) == 0 &&
+                  memcmp(header.fingerprint, fingerprint, sizeof(header.fingerprint)) == 0;
+        if (ok) {
+            bits.resize(header.words);
+            ok = (bool)in.read(reinterpret_cast<char*>(bits.data()), header.words * sizeof(uint64_t));
+        }
+        in.close();
+        remove(path.c_str());
+        if (!ok) {
+            bits.clear();
+            return false;
+        }
+        capacity = header.capacity;
+        keys = header.keys;
+        deletes = header.deletes;
+        return true;
+    }
+
+    void save(const string& path, const uint64_t fingerprint[3]) const {
+        if (bits.empty()) return;
+        Header header = {BLOOM_MAGIC, BLOOM_HASHES, bits.size(), capacity, keys, deletes, {}};
+        memcpy(header.fingerprint, fingerprint, sizeof(header.fingerprint));
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * sizeof(uint64_t));
+        out.close();
+        if (out.fail()) remove(path.c_str());
+    }
+
+    void printStats(const string& label) const {
+        size_t misses = skipped + falsePositives;
+        double load = (double)keys * BLOOM_HASHES / (bits.size() * 64.0);
+        cout << label << " filter: " << (bits.size() * sizeof(uint64_t) >> 10) << " KB for " << keys << " keys"
+             << " (" << deletes << " deleted, capacity " << capacity << ")"
+             << " | Lookups: " << probes << " | Skipped: " << skipped
+             << " | False positives: " << falsePositives
+             << " | FP rate: " << (misses ? (100.0 * falsePositives / misses) : 0.0) << "%"
+             << " (expected " << (bits.empty() ? 0.0 : 100.0 * pow(1.0 - exp(-load), BLOOM_HASHES)) << "%)\n";
+    }
+};
+
+#endif //BLOOM_FILTER_H
@@ -0,0 +1,122 @@
+#ifndef BULK_IMPORT_H
+#define BULK_IMPORT_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// Streams a CSV file one row at a time. Fields may be wrapped in double quotes
+// (with "" as an escaped quote) so names and addresses can contain commas.
+// Surrounding spaces are trimmed from every field.
+class CsvReader {
+private:
+    ifstream in;
+    string line;
+    vector<char> buffer;
+
+    static string trim(const string& s) {
+        size_t b = s.find_first_not_of(" \t");
+        if (b == string::npos) return "";
+        size_t e = s.find_last_not_of(" \t");
+        return s.substr(b, e - b + 1);
+    }
+
+public:
+    explicit CsvReader(const string& path) : buffer(1 << 20) {
+        in.rdbuf()->pubsetbuf(buffer.data(), (streamsize)buffer.size());
+        in.open(path);
+    }
+
+    bool isOpen() const { return in.is_open(); }
+
+    // Reads the next non-empty row into fields. Returns false at end of file.
+    bool next(vector<string>& fields) {
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            fields.clear();
+
+            // Fast path: no quoting on this row
+            if (line.find('"') == string::npos) {
+                size_t start = 0;
+                while (true) {
+                    size_t comma = line.find(',', start);
+                    fields.push_back(trim(line.substr(start, comma == string::npos ? string::npos : comma - start)));
+                    if (comma == string::npos) break;
+                    start = comma + 1;
+                }
+                return true;
+            }
+
+            string field;
+            bool quoted = false;
+            for (size_t i = 0; i < line.size(); i++) {
+                char c = line[i];
+                if (quoted) {
+                    if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                        field += '"';
+                        i++;
+                    } else if (c == '"') {
+                        quoted = false;
+                    } else {
+                        field += c;
+                    }
+                } else if (c == '"') {
+                    quoted = true;
+                } else if (c == ',') {
+                    fields.push_back(trim(field));
+                    field.clear();
+                } else {
+                    field += c;
+                }
+            }
+            fields.push_back(trim(field));
+            return true;
+        }
+        return false;
+    }
+};
+
+// Returns the stable sort order of keys. Each key is packed into a 16-byte big-endian
+// prefix so the sort compares two integers instead of chasing heap strings; the full
+// strings are only compared when the prefixes tie (keys longer than 16 bytes).
+inline vector<uint32_t> importSortOrder(const vector<string>& keys) {
+    struct SortKey {
+        uint64_t hi;
+        uint64_t lo;
+        uint32_t row;
+    };
+    vector<SortKey> packed(keys.size());
+    for (uint32_t i = 0; i < (uint32_t)keys.size(); i++) {
+        unsigned char prefix[16] = {0};
+        memcpy(prefix, keys[i].data(), min<size_t>(16, keys[i].size()));
+        uint64_t hi = 0, lo = 0;
+        for (int b = 0; b < 8; b++) {
+            hi = (hi << 8) | prefix[b];
+            lo = (lo << 8) | prefix[8 + b];
+        }
+        packed[i] = {hi, lo, i};
+    }
+
+    sort(packed.begin(), packed.end(), [&keys](const SortKey& a, const SortKey& b) {
+        if (a.hi != b.hi) return a.hi < b.hi;
+        if (a.lo != b.lo) return a.lo < b.lo;
+        if (keys[a.row].size() > 16 || keys[b.row].size() > 16) {
+            int c = keys[a.row].compare(keys[b.row]);
+            if (c != 0) return c < 0;
+        }
+        return a.row < b.row;
+    });
+
+    vector<uint32_t> order(packed.size());
+    for (size_t i = 0; i < packed.size(); i++) order[i] = packed[i].row;
+    return order;
+}
+
+#endif
@@ -6,16 +6,14 @@
 #include <optional>
 #include <stdexcept>
 #include <filesystem>
+#include <numeric>
 
 #include "IndexManagers.h"
+#include "RecordFile.h"
+#include "BulkImport.h"
 
 using namespace std;
 
-// Global index manager for doctors
-DoctorIndexManager docIndexMgr;
-
-
-
 const string DOC_DATA_FILE = "doctors.dat";
 
 const int DOC_ID_LEN = 15;
@@ -45,53 +43,73 @@ string DoctorReadFixed(const char* src, int size)
     return string(src, len);
 }
 
-//FILE I/O func
-
-long appendDoctorRecord(const DoctorRecord& rec)
+// Doctor IDs are index keys; one longer than the record field is rejected, not cut short
+bool DoctorIdFits(const string& id)
 {
-    fstream file(DOC_DATA_FILE, ios::in | ios::out | ios::binary);
+    if ((int)id.size() <= DOC_ID_LEN) return true;
+    cout << "Error: Doctor ID " << id << " is longer than " << DOC_ID_LEN << " characters.\n";
+    return false;
+}
 
-    if (!file.is_open())
-    {
-        ofstream createFile(DOC_DATA_FILE, ios::out | ios::app | ios::binary);
-        createFile.close();
+//FILE I/O func
 
-        file.open(DOC_DATA_FILE, ios::in | ios::out | ios::binary);
-    }
+// Single open handle on doctors.dat, shared by every DoctorManager instance
+RecordFile docDataFile(DOC_DATA_FILE, sizeof(DoctorRecord));
 
-    file.seekp(0, ios::end);
-    long pos = file.tellp() / sizeof(DoctorRecord);
+long appendDoctorRecord(const DoctorRecord& rec)
+{
+    return docDataFile.append(&rec);
+}
 
-    file.write(reinterpret_cast<const char*>(&rec), sizeof(DoctorRecord));
-    file.close();
 
-    return pos;
+void writeDoctorRecord(long pos, const DoctorRecord& rec)
+{
+    docDataFile.write(pos, &rec);
 }
 
+DoctorRecord readDoctorRecord(long pos) 
+{
+    DoctorRecord rec;
+    docDataFile.read(pos, &rec);
+    return rec;
+}
 
-void writeDoctorRecord(long pos, const DoctorRecord& rec)
+long appendDoctorRecords(const vector<DoctorRecord>& recs)
 {
-    fstream file(DOC_DATA_FILE, ios::in | ios::out | ios::binary);
-    if (!file.is_open()) throw runtime_error("Cannot open doctors.dat");
+    return docDataFile.appendMany(recs.data(), recs.size());
+}
 
-    file.seekp(pos * sizeof(DoctorRecord), ios::beg);
-    file.write(reinterpret_cast<const char*>(&rec), sizeof(DoctorRecord));
-    file.close();
+vector<DoctorRecord> readDoctorRecords(const vector<long>& positions)
+{
+    vector<DoctorRecord> recs(positions.size());
+    docDataFile.readMany(positions, recs.data());
+    return recs;
 }
 
-DoctorRecord readDoctorRecord(long pos) 
+// Doctor names (the secondary key) of the doctors at the given slots.
+vector<string> readDoctorNames(const vector<long>& slots)
 {
-    ifstream file(DOC_DATA_FILE, ios::binary);
-    if (!file.is_open()) throw runtime_error("Cannot open doctors.dat");
+    vector<string> names;
+    names.reserve(slots.size());
+    for (const auto& rec : readDoctorRecords(slots))
+        names.push_back(DoctorReadFixed(rec.doctor_name, DOC_NAME_LEN));
+    return names;
+}
 
-    file.seekg(pos * sizeof(DoctorRecord), ios::beg);
+// Global index manager for doctors, declared after docDataFile so the data file outlives it
+DoctorIndexManager docIndexMgr(readDoctorNames);
 
-    DoctorRecord rec;
-    if (!file.read(reinterpret_cast<char*>(&rec), sizeof(DoctorRecord)))
-        throw runtime_error("Failed to read doctor record");
+// Free slots left behind by deleted doctors (doctors.dat.avail)
+AvailList docAvailList(DOC_DATA_FILE);
 
-    file.close();
-    return rec;
+long getDoctorAvailSlot()
+{
+    return docAvailList.pop();
+}
+
+void addDoctorToAvailList(long pos)
+{
+    docAvailList.push(pos);
 }
 // DOCTOR MANAGER
 class DoctorManager
@@ -100,6 +118,8 @@ public:
 
     bool AddDoctor(const string& id, const string& name, const string& addr)
     {
+        if (!DoctorIdFits(id)) return false;
+
         // Duplicate check
         if (docIndexMgr.searchByPrimary(id))
         {
@@ -114,14 +134,21 @@ public:
         DoctorWriteFixed(rec.address, addr, DOC_ADDRESS_LEN);
         DoctorWriteFixed(rec.status, "Active", DOC_STATUS_LEN);
 
-        // Write to file
-        long pos = appendDoctorRecord(rec);
+        // Write to file, reusing a deleted slot first
+        long pos = getDoctorAvailSlot();
+        if (pos != -1)
+            writeDoctorRecord(pos, rec);
+        else
+            pos = appendDoctorRecord(rec);
+        docDataFile.sync(); // The record is on disk before the index log points at it
 
         // INSERT INTO PRIMARY
-        int indexPos = docIndexMgr.insertPrimary(id, pos);
+        IndexLogGroup group;
+        docIndexMgr.insertPrimary(id, pos);
 
         // INSERT INTO SECONDARY (based on name)
-        docIndexMgr.insertSecondary(name, indexPos);
+        docIndexMgr.insertSecondary(name, pos);
+        group.commit();
 
         return  true;
     }
@@ -148,13 +175,16 @@ public:
 
         string oldName = DoctorReadFixed(rec.doctor_name, DOC_NAME_LEN);
 
-        // Update secondary index
-        docIndexMgr.deleteSecondary(oldName, pos);
-        docIndexMgr.insertSecondary(new_name, pos);
-
         // Update file record
         DoctorWriteFixed(rec.doctor_name, new_name, DOC_NAME_LEN);
         writeDoctorRecord(pos, rec);
+        docDataFile.sync();
+
+        // Update secondary index
+        IndexLogGroup group;
+        docIndexMgr.deleteSecondary(oldName, pos);
+        docIndexMgr.insertSecondary(new_name, pos);
+        group.commit();
     }
 
 
@@ -179,15 +209,22 @@ public:
 
         string doctorName = DoctorReadFixed(rec.doctor_name, DOC_NAME_LEN);
 
-        // Update secondary index
-        docIndexMgr.deleteSecondary(doctorName, pos);
-
         // Mark record as deleted
         DoctorWriteFixed(rec.status, "Deleted", DOC_STATUS_LEN);
         writeDoctorRecord(pos, rec);
+        docDataFile.sync();
+
+        // Update secondary index
+        IndexLogGroup group;
+        docIndexMgr.deleteSecondary(doctorName, pos);
 
         // Remove from primary index
         docIndexMgr.deletePrimary(id);
+        group.commit();
+
+        // The slot is reused only once no index entry can lead to it
+        crashPoint("delete-before-avail");
+        addDoctorToAvailList(pos);
     }
 
 
@@ -209,10 +246,43 @@ public:
     {
         vector<DoctorRecord> result;
 
-        auto entries = docIndexMgr.searchBySecondary(name);
-        for (auto entry : entries)
+        vector<long> offsets = docIndexMgr.searchBySecondary(name);
+
+        for (const auto& rec : readDoctorRecords(offsets))
+        {
+            if (DoctorReadFixed(rec.status, DOC_STATUS_LEN) == "Active")
+                result.push_back(rec);
+        }
+
+        return result;
+    }
+
+
+    // Doctors whose name starts with prefix, ignoring case, in name order
+    vector<DoctorRecord> getByDoctorNamePrefix(const string& prefix)
+    {
+        vector<DoctorRecord> result;
+
+        vector<long> offsets = docIndexMgr.searchBySecondaryPrefix(prefix);
+
+        for (const auto& rec : readDoctorRecords(offsets))
+        {
+            if (DoctorReadFixed(rec.status, DOC_STATUS_LEN) == "Active")
+                result.push_back(rec);
+        }
+
+        return result;
+    }
+
+    // Doctors whose name equals name ignoring case
+    vector<DoctorRecord> getByDoctorNameIgnoreCase(const string& name)
+    {
+        vector<DoctorRecord> result;
+
+        vector<long> offsets = docIndexMgr.searchBySecondaryFolded(name);
+
+        for (const auto& rec : readDoctorRecords(offsets))
         {
-            DoctorRecord rec = readDoctorRecord(entry->offset);
             if (DoctorReadFixed(rec.status, DOC_STATUS_LEN) == "Active")
                 result.push_back(rec);
         }
@@ -221,6 +291,223 @@ public:
     }
 
 
+    // Doctors whose name matches pattern ignoring case, '_' standing for any one character.
+    // With anyTail the name may go on past the pattern (LIKE 'pattern%'). The text before
+    // the first '_' narrows the search to a prefix scan.
+    vector<DoctorRecord> getByDoctorNameLike(const string& pattern, bool anyTail)
+    {
+        vector<DoctorRecord> result;
+
+        vector<long> offsets = docIndexMgr.searchBySecondaryPrefix(pattern.substr(0, pattern.find('_')));
+
+        for (const auto& rec : readDoctorRecords(offsets))
+        {
+            string name = DoctorReadFixed(rec.doctor_name, DOC_NAME_LEN);
+            if (DoctorReadFixed(rec.status, DOC_STATUS_LEN) == "Active" && nameMatches(name, pattern, anyTail))
+                result.push_back(rec);
+        }
+
+        return result;
+    }
+
+    static bool nameMatches(const string& name, const string& pattern, bool anyTail)
+    {
+        if (name.size() < pattern.size() || (!anyTail && name.size() != pattern.size()))
+            return false;
+        for (size_t i = 0; i < pattern.size(); i++)
+        {
+            if (pattern[i] != '_' && tolower((unsigned char)pattern[i]) != tolower((unsigned char)name[i]))
+                return false;
+        }
+        return true;
+    }
+
+
+    // Bulk import of doctor_id,doctor_name,address rows, same approach as
+    // AppointmentManager::importCsv: chunked appends, then one sort to build the indexes.
+    long importCsv(const string& path)
+    {
+        CsvReader csv(path);
+        if (!csv.isOpen())
+        {
+            cout << "Cannot open " << path << "\n";
+            return 0;
+        }
+
+        vector<string> ids;
+        vector<long> offsets;
+        vector<string> names;
+        vector<DoctorRecord> chunk;
+        chunk.reserve(IMPORT_CHUNK_RECORDS);
+        long skipped = 0;
+
+        auto flushChunk = [&]()
+        {
+            long first = appendDoctorRecords(chunk);
+            for (size_t k = 0; k < chunk.size(); k++)
+                offsets.push_back(first + (long)k);
+            chunk.clear();
+        };
+
+        vector<string> f;
+        bool firstRow = true;
+        while (csv.next(f))
+        {
+            if (firstRow && f[0] == "doctor_id")
+            {
+                firstRow = false;
+                continue;
+            }
+            firstRow = false;
+            if (f.size() < 3 || f[0].empty() || !DoctorIdFits(f[0]) || docIndexMgr.searchByPrimary(f[0]))
+            {
+                skipped++;
+                continue;
+            }
+
+            DoctorRecord rec;
+            DoctorWriteFixed(rec.doctor_id, f[0], DOC_ID_LEN);
+            DoctorWriteFixed(rec.doctor_name, f[1], DOC_NAME_LEN);
+            DoctorWriteFixed(rec.address, f[2], DOC_ADDRESS_LEN);
+            DoctorWriteFixed(rec.status, "Active", DOC_STATUS_LEN);
+            chunk.push_back(rec);
+            ids.push_back(f[0]);
+            names.push_back(f[1]);
+
+            if (chunk.size() == IMPORT_CHUNK_RECORDS) flushChunk();
+        }
+        flushChunk();
+
+        vector<uint32_t> order = importSortOrder(ids);
+
+        vector<DocPrimaryIndexEntry> entries;
+        vector<string> sortedNames;
+        vector<long> tombstoned;
+        entries.reserve(ids.size());
+        sortedNames.reserve(ids.size());
+        for (uint32_t row : order)
+        {
+            if (!entries.empty() && entries.back().doctorId == ids[row])
+            {
+                DoctorRecord rec = readDoctorRecord(offsets[row]);
+                DoctorWriteFixed(rec.status, "Deleted", DOC_STATUS_LEN);
+                writeDoctorRecord(offsets[row], rec);
+                tombstoned.push_back(offsets[row]);
+                skipped++;
+                continue;
+            }
+            entries.push_back({std::move(ids[row]), offsets[row]});
+            sortedNames.push_back(std::move(names[row]));
+        }
+
+        long imported = (long)entries.size();
+        docDataFile.sync();
+        docIndexMgr.bulkInsert(entries, sortedNames);
+        for (long pos : tombstoned)
+            addDoctorToAvailList(pos);
+        cout << "Imported " << imported << " doctors (" << skipped << " rows skipped)\n";
+        return imported;
+    }
+
+    // Vacuum for doctors.dat, same approach as AppointmentManager::compact
+    long compact()
+    {
+        const auto& primary = docIndexMgr.primaryEntries();
+        vector<DocPrimaryIndexEntry> entries(primary.begin(), primary.end());
+        vector<size_t> byOffset(entries.size());
+        iota(byOffset.begin(), byOffset.end(), 0);
+        sort(byOffset.begin(), byOffset.end(), [&entries](size_t a, size_t b)
+        {
+            return entries[a].offset < entries[b].offset;
+        });
+
+        long before = docDataFile.size();
+        vector<string> names(entries.size());
+
+        string tmpPath = DOC_DATA_FILE + ".compact";
+        remove(tmpPath.c_str());
+        {
+            RecordFile out(tmpPath, sizeof(DoctorRecord));
+            out.size(); // Creates the file even when no record is kept
+            for (size_t start = 0; start < byOffset.size(); start += IMPORT_CHUNK_RECORDS)
+            {
+                size_t end = min(byOffset.size(), start + IMPORT_CHUNK_RECORDS);
+                vector<long> positions;
+                for (size_t k = start; k < end; k++)
+                    positions.push_back(entries[byOffset[k]].offset);
+
+                vector<DoctorRecord> recs = readDoctorRecords(positions);
+                long first = out.appendMany(recs.data(), recs.size());
+                for (size_t k = start; k < end; k++)
+                {
+                    entries[byOffset[k]].offset = first + (long)(k - start);
+                    names[byOffset[k]] = DoctorReadFixed(recs[k - start].doctor_name, DOC_NAME_LEN);
+                }
+            }
+            out.sync();
+        }
+
+        string marker = DOC_DATA_FILE + ".compacting";
+        ofstream(marker).close();
+        docDataFile.replaceWith(tmpPath);
+        docAvailList.clear();
+        long kept = (long)entries.size();
+        docIndexMgr.rebuild(entries, names);
+        remove(marker.c_str());
+        cout << "Compacted doctors.dat: " << before << " -> " << kept << " records\n";
+        return kept;
+    }
+
+    // Finishes a doctor compaction that was cut short, same as AppointmentManager::recoverCompaction
+    bool recoverCompaction()
+    {
+        string marker = DOC_DATA_FILE + ".compacting";
+        if (!filesystem::exists(marker)) return false;
+        remove((DOC_DATA_FILE + ".compact").c_str());
+
+        vector<DocPrimaryIndexEntry> active;
+        vector<string> activeNames;
+        vector<long> freeSlots;
+        docAvailList.clear();
+        long count = docDataFile.size();
+        for (long start = 0; start < count; start += (long)IMPORT_CHUNK_RECORDS)
+        {
+            vector<long> positions(min<long>(count - start, (long)IMPORT_CHUNK_RECORDS));
+            iota(positions.begin(), positions.end(), start);
+            vector<DoctorRecord> recs = readDoctorRecords(positions);
+            for (size_t k = 0; k < recs.size(); k++)
+            {
+                if (DoctorReadFixed(recs[k].status, DOC_STATUS_LEN) != "Active")
+                {
+                    freeSlots.push_back(positions[k]);
+                    continue;
+                }
+                active.push_back({DoctorReadFixed(recs[k].doctor_id, DOC_ID_LEN), positions[k]});
+                activeNames.push_back(DoctorReadFixed(recs[k].doctor_name, DOC_NAME_LEN));
+            }
+        }
+
+        vector<size_t> byKey(active.size());
+        iota(byKey.begin(), byKey.end(), 0);
+        sort(byKey.begin(), byKey.end(), [&active](size_t a, size_t b) { return active[a] < active[b]; });
+        vector<DocPrimaryIndexEntry> entries;
+        vector<string> names;
+        entries.reserve(active.size());
+        names.reserve(active.size());
+        for (size_t i : byKey)
+        {
+            entries.push_back(std::move(active[i]));
+            names.push_back(std::move(activeNames[i]));
+        }
+
+        docIndexMgr.rebuild(entries, names);
+        for (long pos : freeSlots)
+            addDoctorToAvailList(pos);
+        remove(marker.c_str());
+        cout << "Rebuilt the doctor indexes after an interrupted compaction\n";
+        return true;
+    }
+
     static void printRecord(const DoctorRecord& rec)
 {
         cout << "DoctorID: " << DoctorReadFixed(rec.doctor_id, DOC_ID_LEN)
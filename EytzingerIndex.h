@@ -0,0 +1,144 @@
+#ifndef EYTZINGER_INDEX_H
+#define EYTZINGER_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#include "FixedKey.h"
+
+using namespace std;
+
+// READ-OPTIMIZED PRIMARY INDEX SNAPSHOT
+// A copy of the primary index laid out in Eytzinger (BFS) order: the children of slot k
+// are 2k and 2k + 1, so the first levels of every search share a few cache lines and
+// the descendants of k four levels down (16k .. 16k + 15) are contiguous. Keys are kept
+// apart from the entries as pairs of big-endian 64-bit words in a cache-line aligned
+// array, four to a line, so each step prefetches the four lines it will need four steps
+// later and compares with plain integer compares and no data-dependent branch.
+//
+// The snapshot is only valid until the next write. The owner invalidates it on every
+// insert / delete and rebuilds it (O(n)) once due() has seen enough lookups since the
+// last write to pay for the copy, or right after a bulk change. Indexes smaller than
+// EYTZINGER_MIN_ENTRIES fit in cache anyway and are never snapshotted.
+
+// Hints that the cache line at address will be read soon. It is never dereferenced, so it
+// may lie past the end of the array (a prefetch does not fault); compilers without a
+// prefetch intrinsic get a no-op.
+inline void prefetchLine(uintptr_t address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(reinterpret_cast<const void*>(address));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+const size_t EYTZINGER_MIN_ENTRIES = 4096;
+const size_t EYTZINGER_REBUILD_RATIO = 4; // Rebuild after size / ratio lookups since the last write
+
+template <class Entry>
+class EytzingerIndex {
+private:
+    struct Key {
+        uint64_t hi, lo; // Key bytes 0-7 and 8-15 read big-endian
+    };
+    struct alignas(64) Line {
+        Key keys[4];
+    };
+
+    vector<Line> lines;     // Key of slot k is keyAt(k); slot 0 is unused
+    vector<Entry> entries;  // Entry of slot k, same order
+    size_t n = 0;
+    bool valid = false;
+    size_t lookups = 0;     // Since the last write
+
+    Key* keyData() { return lines.empty() ? nullptr : lines.data()->keys; }
+    const Key* keyData() const { return lines.empty() ? nullptr : lines.data()->keys; }
+
+    static uint64_t bigEndianWord(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+        return v;
+    }
+    static Key toKey(const FixedKey& key) {
+        return {bigEndianWord(key.bytes), bigEndianWord(key.bytes + 8)};
+    }
+    static bool keyLess(const Key& a, const Key& b) {
+        return (a.hi < b.hi) | ((a.hi == b.hi) & (a.lo < b.lo));
+    }
+
+    // Copies the sorted range into the BFS slots by an in-order walk of the implicit tree.
+    template <class It, class KeyOf>
+    void fill(It& it, size_t k, KeyOf& keyOf) {
+        if (k > n) return;
+        fill(it, 2 * k, keyOf);
+        keyData()[k] = toKey(keyOf(*it));
+        entries[k] = *it;
+        ++it;
+        fill(it, 2 * k + 1, keyOf);
+    }
+
+public:
+    bool current() const { return valid; }
+
+    void invalidate() {
+        valid = false;
+        lookups = 0;
+    }
+
+    // Counts a lookup that missed the snapshot; true once a rebuild is worth it.
+    bool due(size_t size) {
+        if (size < EYTZINGER_MIN_ENTRIES) return false;
+        return ++lookups >= size / EYTZINGER_REBUILD_RATIO;
+    }
+
+    // Rebuilds from a store iterated in key order; keyOf returns an entry's FixedKey.
+    template <class Store, class KeyOf>
+    void build(const Store& sorted, KeyOf keyOf) {
+        lookups = 0;
+        n = sorted.size();
+        valid = n >= EYTZINGER_MIN_ENTRIES;
+        if (!valid) {
+            n = 0;
+            lines.clear();
+            lines.shrink_to_fit();
+            entries.clear();
+            entries.shrink_to_fit();
+            return;
+        }
+        lines.resize(n / 4 + 1);
+        entries.resize(n + 1);
+        auto it = sorted.begin();
+        fill(it, 1, keyOf);
+    }
+
+    // Entry whose key equals key, or nullptr.
+    const Entry* find(const FixedKey& key) const {
+        const Key probe = toKey(key);
+        const Key* keys = keyData();
+        size_t k = 1;
+        while (k <= n) {
+            // Slots 16k .. 16k + 15 are four whole lines, past the end near the leaves, so
+            // the address is computed as an integer rather than as a pointer into keys
+            uintptr_t ahead = reinterpret_cast<uintptr_t>(keys) + 16 * k * sizeof(Key);
+            prefetchLine(ahead);
+            prefetchLine(ahead + 64);
+            prefetchLine(ahead + 128);
+            prefetchLine(ahead + 192);
+            k = 2 * k + (size_t)keyLess(keys[k], probe);
+        }
+        // Undo the trailing right turns (and the final left one) to reach the lower bound
+        k >>= countr_one(k) + 1;
+        if (k == 0 || keys[k].hi != probe.hi || keys[k].lo != probe.lo) return nullptr;
+        return &entries[k];
+    }
+};
+
+#endif //EYTZINGER_INDEX_H
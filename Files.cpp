@@ -5,22 +5,26 @@
 #include <cstring>
 #include <stdexcept>
 #include <optional>
+#include <algorithm>
+#include <numeric>
 #include "IndexManagers.h"
+#include "RecordFile.h"
+#include "BulkImport.h"
 using namespace std;
 
-// Definition for the global index manager instance
-AppointmentIndexManager apptIndexMgr;
+const string APPT_DATA_FILE = "appointments.dat";
 
-long getAppointmentAvailSlot(size_t record_size) {
-    return -1;
-}
+// Free slots left behind by deleted appointments (appointments.dat.avail)
+AvailList apptAvailList(APPT_DATA_FILE);
 
-// Mock: Prints a message instead of managing an actual linked list of free slots.
-void addAppointmentToAvailList(long offset, size_t record_size) {
-    cout << "--- Mock: Added record at disk offset " << offset << " to Avail List ---\n";
+// Returns a deleted record slot to reuse, or -1 if the file has to grow.
+long getAppointmentAvailSlot() {
+    return apptAvailList.pop();
 }
 
-const string APPT_DATA_FILE = "appointments.dat";
+void addAppointmentToAvailList(long offset) {
+    apptAvailList.push(offset);
+}
 
 // Fixed sizes for fields
 const int ID_LEN = 15;
@@ -30,6 +34,9 @@ const int DATE_LEN = 12;
 const int TIME_LEN = 8;
 const int STATUS_LEN = 8;
 
+// Records buffered per write during a bulk import
+const size_t IMPORT_CHUNK_RECORDS = 65536;
+
 // Struct for Appointment Record
 struct AppointmentRecord {
     char appointment_id[ID_LEN];
@@ -54,38 +61,147 @@ string readFixed(const char* src, int size) {
     return string(src, len);
 }
 
+// IDs are index keys: one longer than its record field would be stored cut short, and
+// two IDs that differ only past the cut would collide, so such IDs are rejected.
+bool idFits(const string& what, const string& id, int size) {
+    if ((int)id.size() <= size) return true;
+    cout << "Error: " << what << " " << id << " is longer than " << size << " characters.\n";
+    return false;
+}
+
 // Data file I/O operations
+// All record access goes through one long-lived handle on appointments.dat.
+RecordFile apptDataFile(APPT_DATA_FILE, sizeof(AppointmentRecord));
+
 long appendRecord(const AppointmentRecord& rec) {
-    fstream file(APPT_DATA_FILE, ios::in | ios::out | ios::binary);
-    if (!file.is_open()) {
-        file.open(APPT_DATA_FILE, ios::out | ios::binary);
-        file.close();
-        file.open(APPT_DATA_FILE, ios::in | ios::out | ios::binary);
-    }
-    file.seekp(0, ios::end);
-    long pos = file.tellp() / sizeof(AppointmentRecord);
-    file.write(reinterpret_cast<const char*>(&rec), sizeof(AppointmentRecord));
-    file.close();
-    return pos;
+    return apptDataFile.append(&rec);
 }
 void writeRecord(long pos, const AppointmentRecord& rec) {
-    fstream file(APPT_DATA_FILE, ios::in | ios::out | ios::binary);
-    if (!file.is_open()) throw runtime_error("Cannot open data file");
-    file.seekp(pos * sizeof(AppointmentRecord), ios::beg);
-    file.write(reinterpret_cast<const char*>(&rec), sizeof(AppointmentRecord));
-    file.close();
+    apptDataFile.write(pos, &rec);
 }
 AppointmentRecord readRecord(long pos) {
-    ifstream file(APPT_DATA_FILE, ios::binary);
-    if (!file.is_open()) throw runtime_error("Cannot open data file");
-    file.seekg(pos * sizeof(AppointmentRecord), ios::beg);
     AppointmentRecord rec;
-    if (!file.read(reinterpret_cast<char*>(&rec), sizeof(AppointmentRecord))) {
-        throw runtime_error("Failed to read record at position " + to_string(pos));
-    }
-    file.close();
+    apptDataFile.read(pos, &rec);
     return rec;
 }
+// Appends a batch of records with one write; returns the slot of the first one.
+long appendRecords(const vector<AppointmentRecord>& recs) {
+    return apptDataFile.appendMany(recs.data(), recs.size());
+}
+// Reads several records in one pass; results come back in the order of positions.
+vector<AppointmentRecord> readRecords(const vector<long>& positions) {
+    vector<AppointmentRecord> recs(positions.size());
+    apptDataFile.readMany(positions, recs.data());
+    return recs;
+}
+// Doctor IDs (the secondary key) of the appointments at the given slots.
+vector<string> readAppointmentDoctorIds(const vector<long>& slots) {
+    vector<string> ids;
+    ids.reserve(slots.size());
+    for (const auto& rec : readRecords(slots)) ids.push_back(readFixed(rec.doctor_id, DID_LEN));
+    return ids;
+}
+
+// Definition for the global index manager instance. Declared after apptDataFile so the
+// data file outlives the managers (whose destructors join the prefetch thread).
+AppointmentIndexManager apptIndexMgr(readAppointmentDoctorIds);
+AppointmentDateIndexManager apptDateIndex;
+AppointmentPatientIndexManager apptPatientIndex;
+AppointmentDoctorDayIndexManager apptDoctorDayIndex;
+
+// ORDERED INDEXES
+// (date, time), (patientId, date, time) and (doctorId, date, time), kept in step with
+// the primary index by every mutation below.
+
+CompositeKey<2> dateKey(const string& date, const string& time) {
+    return {{FixedKey(date), FixedKey(time)}};
+}
+// (patientId or doctorId, date, time)
+CompositeKey<3> idDateKey(const string& id, const string& date, const string& time) {
+    return {{FixedKey(id), FixedKey(date), FixedKey(time)}};
+}
+
+struct OrderedKeys {
+    CompositeKey<2> date;
+    CompositeKey<3> patient;
+    CompositeKey<3> doctorDay;
+};
+
+OrderedKeys orderedKeys(const string& patientId, const string& doctorId, const string& date, const string& time) {
+    return {dateKey(date, time), idDateKey(patientId, date, time), idDateKey(doctorId, date, time)};
+}
+OrderedKeys orderedKeysOf(const AppointmentRecord& rec) {
+    return orderedKeys(readFixed(rec.patient_id, PID_LEN), readFixed(rec.doctor_id, DID_LEN),
+                       readFixed(rec.date, DATE_LEN), readFixed(rec.time, TIME_LEN));
+}
+
+void insertOrdered(const OrderedKeys& keys, long pos) {
+    apptDateIndex.insert(keys.date, pos);
+    apptPatientIndex.insert(keys.patient, pos);
+    apptDoctorDayIndex.insert(keys.doctorDay, pos);
+}
+void eraseOrdered(const OrderedKeys& keys, long pos) {
+    apptDateIndex.erase(keys.date, pos);
+    apptPatientIndex.erase(keys.patient, pos);
+    apptDoctorDayIndex.erase(keys.doctorDay, pos);
+}
+
+// Entries for a bulk load or a rebuild of all the ordered indexes.
+struct OrderedIndexBatch {
+    vector<AppointmentDateIndexManager::Entry> dates;
+    vector<AppointmentPatientIndexManager::Entry> patients;
+    vector<AppointmentDoctorDayIndexManager::Entry> doctorDays;
+
+    void reserve(size_t n) {
+        dates.reserve(n);
+        patients.reserve(n);
+        doctorDays.reserve(n);
+    }
+    void add(const OrderedKeys& keys, long pos) {
+        dates.push_back({keys.date, pos});
+        patients.push_back({keys.patient, pos});
+        doctorDays.push_back({keys.doctorDay, pos});
+    }
+    void bulkInsert() {
+        apptDateIndex.bulkInsert(dates);
+        apptPatientIndex.bulkInsert(patients);
+        apptDoctorDayIndex.bulkInsert(doctorDays);
+    }
+    void rebuild() {
+        apptDateIndex.rebuild(dates);
+        apptPatientIndex.rebuild(patients);
+        apptDoctorDayIndex.rebuild(doctorDays);
+    }
+};
+
+// Data files written before an ordered index existed have no base for it. The first time
+// the ordered indexes are used they are rebuilt from the records unless each of them
+// covers every indexed appointment.
+bool apptOrderedIndexesChecked = false;
+void ensureOrderedIndexes() {
+    if (apptOrderedIndexesChecked) return;
+    apptOrderedIndexesChecked = true;
+    const auto& primary = apptIndexMgr.primaryEntries();
+    if (apptDateIndex.size() == primary.size() && apptPatientIndex.size() == primary.size() &&
+        apptDoctorDayIndex.size() == primary.size()) {
+        return;
+    }
+
+    vector<long> positions;
+    positions.reserve(primary.size());
+    for (const auto& e : primary) positions.push_back(e.offset);
+    sort(positions.begin(), positions.end());
+
+    OrderedIndexBatch batch;
+    batch.reserve(positions.size());
+    for (size_t start = 0; start < positions.size(); start += IMPORT_CHUNK_RECORDS) {
+        vector<long> chunk(positions.begin() + start,
+                           positions.begin() + min(positions.size(), start + IMPORT_CHUNK_RECORDS));
+        vector<AppointmentRecord> recs = readRecords(chunk);
+        for (size_t k = 0; k < recs.size(); k++) batch.add(orderedKeysOf(recs[k]), chunk[k]);
+    }
+    batch.rebuild();
+}
 
 // APPOINTMENT MANAGER CLASS
 
@@ -94,12 +210,17 @@ public:
     AppointmentManager() {}
     ~AppointmentManager() {}
 
-    void addAppointment(const string& appId, const string& patientId, const string& doctorId,
+    bool addAppointment(const string& appId, const string& patientId, const string& doctorId,
                         const string& date, const string& time) {
+        if (!idFits("Appointment ID", appId, ID_LEN) || !idFits("Patient ID", patientId, PID_LEN) ||
+            !idFits("Doctor ID", doctorId, DID_LEN)) {
+            return false;
+        }
         if (apptIndexMgr.searchByPrimary(appId)) {
             cout << "Appointment ID " << appId << " already exists\n";
-            return;
+            return false;
         }
+        ensureOrderedIndexes();
 
         AppointmentRecord rec;
         writeFixed(rec.appointment_id, appId, ID_LEN);
@@ -109,18 +230,21 @@ public:
         writeFixed(rec.time, time, TIME_LEN);
         writeFixed(rec.status, "Active", STATUS_LEN);
 
-        long pos;
-        size_t record_size = sizeof(AppointmentRecord);
-        pos = getAppointmentAvailSlot(record_size);
+        long pos = getAppointmentAvailSlot();
 
         if (pos != -1) {
             writeRecord(pos, rec);
         } else {
             pos = appendRecord(rec);
         }
-
-        int primaryPos = apptIndexMgr.insertPrimary(appId, pos);
-        apptIndexMgr.insertSecondary(doctorId, primaryPos);
+        apptDataFile.sync(); // The record is on disk before the index log points at it
+
+        IndexLogGroup group; // One fsync per index log, before the add is acknowledged
+        apptIndexMgr.insertPrimary(appId, pos);
+        apptIndexMgr.insertSecondary(doctorId, pos);
+        insertOrdered(orderedKeys(patientId, doctorId, date, time), pos);
+        group.commit();
+        return true;
     }
 
     void updateAppointmentDate(const string& appId, const string& newDate, const string& newTime) {
@@ -138,9 +262,16 @@ public:
             return;
         }
 
+        ensureOrderedIndexes();
+        OrderedKeys oldKeys = orderedKeysOf(rec);
         writeFixed(rec.date, newDate, DATE_LEN);
         writeFixed(rec.time, newTime, TIME_LEN);
         writeRecord(pos, rec);
+        apptDataFile.sync();
+        IndexLogGroup group;
+        eraseOrdered(oldKeys, pos);
+        insertOrdered(orderedKeysOf(rec), pos);
+        group.commit();
     }
 
     void deleteAppointment(const string& appId) {
@@ -157,32 +288,34 @@ public:
             cout << "Appointment already deleted\n";
             return;
         }
+        ensureOrderedIndexes();
 
         writeFixed(rec.status, "Deleted", STATUS_LEN);
         writeRecord(pos, rec);
-        addAppointmentToAvailList(pos, sizeof(AppointmentRecord));
+        apptDataFile.sync();
 
         string doctorId = readFixed(rec.doctor_id, DID_LEN);
 
-        int deletedPos = apptIndexMgr.deletePrimary(appId);
-
-        if (deletedPos != -1) {
-            apptIndexMgr.deleteSecondary(doctorId, deletedPos);
+        IndexLogGroup group;
+        if (apptIndexMgr.deletePrimary(appId) != -1) {
+            apptIndexMgr.deleteSecondary(doctorId, pos);
+            eraseOrdered(orderedKeysOf(rec), pos);
         }
+        group.commit();
+        // The slot is reused only once no index entry can lead to it
+        crashPoint("delete-before-avail");
+        addAppointmentToAvailList(pos);
     }
 
     vector<AppointmentRecord> getByDoctorId(const string& doctorId) {
         vector<AppointmentRecord> result;
 
-        vector<const ApptPrimaryIndexEntry*> primaryEntries = apptIndexMgr.searchBySecondary(doctorId);
+        // Fetch the whole list in file order with coalesced reads, keep list order in the result
+        vector<long> offsets = apptIndexMgr.searchBySecondary(doctorId);
 
-        for (const auto* entry : primaryEntries) {
-            try {
-                AppointmentRecord rec = readRecord(entry->offset);
-                if (readFixed(rec.status, STATUS_LEN) == "Active") {
-                    result.push_back(rec);
-                }
-            } catch (const runtime_error& e) {
+        for (const auto& rec : readRecords(offsets)) {
+            if (readFixed(rec.status, STATUS_LEN) == "Active") {
+                result.push_back(rec);
             }
         }
         return result;
@@ -204,6 +337,255 @@ public:
         return nullopt;
     }
 
+    // A patient's active appointments, in date and time order.
+    vector<AppointmentRecord> getByPatientId(const string& patientId) {
+        ensureOrderedIndexes();
+        vector<long> offsets = apptPatientIndex.range(idDateKey(patientId, "", ""),
+                                                      {{FixedKey(patientId), FixedKey::highest(), FixedKey::highest()}});
+
+        vector<AppointmentRecord> result;
+        for (const auto& rec : readRecords(offsets)) {
+            if (readFixed(rec.status, STATUS_LEN) == "Active") {
+                result.push_back(rec);
+            }
+        }
+        return result;
+    }
+
+    // A doctor's active appointments on one date, in time order. Reads only that day's
+    // records, however long the doctor's history.
+    vector<AppointmentRecord> getByDoctorOnDate(const string& doctorId, const string& date) {
+        ensureOrderedIndexes();
+        vector<long> offsets = apptDoctorDayIndex.range(idDateKey(doctorId, date, ""),
+                                                        {{FixedKey(doctorId), FixedKey(date), FixedKey::highest()}});
+
+        vector<AppointmentRecord> result;
+        for (const auto& rec : readRecords(offsets)) {
+            if (readFixed(rec.status, STATUS_LEN) == "Active") {
+                result.push_back(rec);
+            }
+        }
+        return result;
+    }
+
+    // Active appointments from one date to another (inclusive), in date and time order.
+    // Only the matching records are read.
+    vector<AppointmentRecord> getByDateRange(const string& fromDate, const string& toDate) {
+        ensureOrderedIndexes();
+        vector<long> offsets = apptDateIndex.range(dateKey(fromDate, ""), {{FixedKey(toDate), FixedKey::highest()}});
+
+        vector<AppointmentRecord> result;
+        for (const auto& rec : readRecords(offsets)) {
+            if (readFixed(rec.status, STATUS_LEN) == "Active") {
+                result.push_back(rec);
+            }
+        }
+        return result;
+    }
+
+    // A day's schedule, in time order.
+    vector<AppointmentRecord> getByDate(const string& date) {
+        return getByDateRange(date, date);
+    }
+
+    // Bulk import: streams appointment_id,patient_id,doctor_id,date,time rows from a CSV
+    // (an optional header row is skipped), appends them in large writes and merges them
+    // into the indexes with a single sort. Rows whose ID already exists are skipped;
+    // repeated IDs inside the file keep the first row and tombstone the rest.
+    long importCsv(const string& path) {
+        CsvReader csv(path);
+        if (!csv.isOpen()) {
+            cout << "Cannot open " << path << "\n";
+            return 0;
+        }
+
+        vector<string> ids;
+        vector<long> offsets;
+        vector<string> doctorIds;
+        vector<OrderedKeys> keys;
+        vector<AppointmentRecord> chunk;
+        chunk.reserve(IMPORT_CHUNK_RECORDS);
+        long skipped = 0;
+
+        auto flushChunk = [&]() {
+            long first = appendRecords(chunk);
+            for (size_t k = 0; k < chunk.size(); k++) {
+                offsets.push_back(first + (long)k);
+            }
+            chunk.clear();
+        };
+
+        ensureOrderedIndexes();
+        vector<string> f;
+        bool firstRow = true;
+        while (csv.next(f)) {
+            if (firstRow && f[0] == "appointment_id") {
+                firstRow = false;
+                continue;
+            }
+            firstRow = false;
+            if (f.size() < 5 || f[0].empty() || !idFits("Appointment ID", f[0], ID_LEN) ||
+                !idFits("Patient ID", f[1], PID_LEN) || !idFits("Doctor ID", f[2], DID_LEN) ||
+                apptIndexMgr.searchByPrimary(f[0])) {
+                skipped++;
+                continue;
+            }
+
+            AppointmentRecord rec;
+            writeFixed(rec.appointment_id, f[0], ID_LEN);
+            writeFixed(rec.patient_id, f[1], PID_LEN);
+            writeFixed(rec.doctor_id, f[2], DID_LEN);
+            writeFixed(rec.date, f[3], DATE_LEN);
+            writeFixed(rec.time, f[4], TIME_LEN);
+            writeFixed(rec.status, "Active", STATUS_LEN);
+            chunk.push_back(rec);
+            ids.push_back(f[0]);
+            doctorIds.push_back(f[2]);
+            keys.push_back(orderedKeys(f[1], f[2], f[3], f[4]));
+
+            if (chunk.size() == IMPORT_CHUNK_RECORDS) flushChunk();
+        }
+        flushChunk();
+
+        // Stable order keeps the earliest row first among repeated IDs
+        vector<uint32_t> order = importSortOrder(ids);
+
+        vector<ApptPrimaryIndexEntry> entries;
+        vector<string> sortedDoctorIds;
+        vector<long> tombstoned;
+        OrderedIndexBatch batch;
+        entries.reserve(ids.size());
+        sortedDoctorIds.reserve(ids.size());
+        batch.reserve(ids.size());
+        for (uint32_t row : order) {
+            if (!entries.empty() && entries.back().appointmentId == ids[row]) {
+                AppointmentRecord rec = readRecord(offsets[row]);
+                writeFixed(rec.status, "Deleted", STATUS_LEN);
+                writeRecord(offsets[row], rec);
+                tombstoned.push_back(offsets[row]);
+                skipped++;
+                continue;
+            }
+            entries.push_back({std::move(ids[row]), offsets[row]});
+            sortedDoctorIds.push_back(std::move(doctorIds[row]));
+            batch.add(keys[row], offsets[row]);
+        }
+
+        long imported = (long)entries.size();
+        apptDataFile.sync();
+        apptIndexMgr.bulkInsert(entries, sortedDoctorIds);
+        batch.bulkInsert();
+        for (long pos : tombstoned) addAppointmentToAvailList(pos);
+        cout << "Imported " << imported << " appointments (" << skipped << " rows skipped)\n";
+        return imported;
+    }
+
+    // Vacuum: rewrites appointments.dat with only the records the primary index still
+    // points to (kept in their current file order), swaps it in, and rebuilds the
+    // indexes against the new slots. Tombstones and the avail list are gone afterwards.
+    long compact() {
+        const auto& primary = apptIndexMgr.primaryEntries();
+        vector<ApptPrimaryIndexEntry> entries(primary.begin(), primary.end());
+        vector<size_t> byOffset(entries.size());
+        iota(byOffset.begin(), byOffset.end(), 0);
+        sort(byOffset.begin(), byOffset.end(), [&entries](size_t a, size_t b) {
+            return entries[a].offset < entries[b].offset;
+        });
+
+        long before = apptDataFile.size();
+        vector<string> doctorIds(entries.size());
+        OrderedIndexBatch batch;
+        batch.reserve(entries.size());
+
+        string tmpPath = APPT_DATA_FILE + ".compact";
+        remove(tmpPath.c_str());
+        {
+            RecordFile out(tmpPath, sizeof(AppointmentRecord));
+            out.size(); // Creates the file even when no record is kept
+            for (size_t start = 0; start < byOffset.size(); start += IMPORT_CHUNK_RECORDS) {
+                size_t end = min(byOffset.size(), start + IMPORT_CHUNK_RECORDS);
+                vector<long> positions;
+                positions.reserve(end - start);
+                for (size_t k = start; k < end; k++) {
+                    positions.push_back(entries[byOffset[k]].offset);
+                }
+
+                vector<AppointmentRecord> recs = readRecords(positions);
+                long first = out.appendMany(recs.data(), recs.size());
+                for (size_t k = start; k < end; k++) {
+                    entries[byOffset[k]].offset = first + (long)(k - start);
+                    doctorIds[byOffset[k]] = readFixed(recs[k - start].doctor_id, DID_LEN);
+                    batch.add(orderedKeysOf(recs[k - start]), entries[byOffset[k]].offset);
+                }
+            }
+            out.sync();
+        }
+
+        // The marker stays until the indexes match the new slots; see recoverCompaction
+        string marker = APPT_DATA_FILE + ".compacting";
+        ofstream(marker).close();
+        apptDataFile.replaceWith(tmpPath);
+        apptAvailList.clear();
+        long kept = (long)entries.size();
+        apptIndexMgr.rebuild(entries, doctorIds);
+        batch.rebuild();
+        apptOrderedIndexesChecked = true;
+        remove(marker.c_str());
+        cout << "Compacted appointments.dat: " << before << " -> " << kept << " records\n";
+        return kept;
+    }
+
+    // A compaction that was cut short leaves its marker behind, and appointments.dat may
+    // already be the compacted copy while the indexes still hold the old slots. Rebuilds
+    // every appointment index and the avail list from the records in that case.
+    // Returns true if it had to.
+    bool recoverCompaction() {
+        string marker = APPT_DATA_FILE + ".compacting";
+        if (!filesystem::exists(marker)) return false;
+        remove((APPT_DATA_FILE + ".compact").c_str());
+
+        vector<ApptPrimaryIndexEntry> active;
+        vector<string> activeDoctorIds;
+        vector<long> freeSlots;
+        OrderedIndexBatch batch;
+        apptAvailList.clear();
+        long count = apptDataFile.size();
+        for (long start = 0; start < count; start += (long)IMPORT_CHUNK_RECORDS) {
+            vector<long> positions(min<long>(count - start, (long)IMPORT_CHUNK_RECORDS));
+            iota(positions.begin(), positions.end(), start);
+            vector<AppointmentRecord> recs = readRecords(positions);
+            for (size_t k = 0; k < recs.size(); k++) {
+                if (readFixed(recs[k].status, STATUS_LEN) != "Active") {
+                    freeSlots.push_back(positions[k]);
+                    continue;
+                }
+                active.push_back({readFixed(recs[k].appointment_id, ID_LEN), positions[k]});
+                activeDoctorIds.push_back(readFixed(recs[k].doctor_id, DID_LEN));
+                batch.add(orderedKeysOf(recs[k]), positions[k]);
+            }
+        }
+
+        vector<size_t> byKey(active.size());
+        iota(byKey.begin(), byKey.end(), 0);
+        sort(byKey.begin(), byKey.end(), [&active](size_t a, size_t b) { return active[a] < active[b]; });
+        vector<ApptPrimaryIndexEntry> entries;
+        vector<string> doctorIds;
+        entries.reserve(active.size());
+        doctorIds.reserve(active.size());
+        for (size_t i : byKey) {
+            entries.push_back(std::move(active[i]));
+            doctorIds.push_back(std::move(activeDoctorIds[i]));
+        }
+
+        apptIndexMgr.rebuild(entries, doctorIds);
+        batch.rebuild();
+        apptOrderedIndexesChecked = true;
+        for (long pos : freeSlots) addAppointmentToAvailList(pos);
+        remove(marker.c_str());
+        cout << "Rebuilt the appointment indexes after an interrupted compaction\n";
+        return true;
+    }
+
     static void printRecord(const AppointmentRecord& rec) {
         cout << "AppointmentID: " << readFixed(rec.appointment_id, ID_LEN)
              << " | PatientID: " << readFixed(rec.patient_id, PID_LEN)
@@ -0,0 +1,87 @@
+#ifndef FIXED_KEY_H
+#define FIXED_KEY_H
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <ostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FIXED_KEY_SSE2 1
+#endif
+
+using namespace std;
+
+// FIXED-WIDTH KEY
+// Primary keys stored inline: FIXED_KEY_BYTES bytes, zero-padded, no heap allocation.
+// IDs live in 15-byte record fields (ID_LEN / DOC_ID_LEN) and longer IDs are rejected
+// on input and import, so every stored ID fits; a longer lookup key is cut to
+// FIXED_KEY_BYTES, which no stored key can equal. Zero padding keeps byte order equal to
+// std::string order (a shorter key sorts before any key it prefixes), i.e. a key
+// compares like a 128-bit big-endian integer, and the on-disk index order is unchanged.
+// With SSE2 a comparison is one 16-byte compare plus a scan for the first differing byte.
+
+const size_t FIXED_KEY_BYTES = 16;
+
+struct FixedKey {
+    unsigned char bytes[FIXED_KEY_BYTES];
+
+    FixedKey() { memset(bytes, 0, sizeof(bytes)); }
+    FixedKey(const string& s) { assign(s.data(), s.size()); }
+    FixedKey(string_view s) { assign(s.data(), s.size()); }
+    FixedKey(const char* s) { assign(s, strlen(s)); }
+
+    void assign(const char* s, size_t len) {
+        if (len > FIXED_KEY_BYTES) len = FIXED_KEY_BYTES;
+        memset(bytes, 0, sizeof(bytes));
+        memcpy(bytes, s, len);
+    }
+
+    // Key from FIXED_KEY_BYTES raw bytes, as stored in index files.
+    static FixedKey fromBytes(const unsigned char* raw) {
+        FixedKey key;
+        memcpy(key.bytes, raw, sizeof(key.bytes));
+        return key;
+    }
+
+    // No key built from a string orders after it; upper bound for range scans.
+    static FixedKey highest() {
+        FixedKey key;
+        memset(key.bytes, 0xFF, sizeof(key.bytes));
+        return key;
+    }
+
+    const char* data() const { return reinterpret_cast<const char*>(bytes); }
+    size_t size() const {
+        size_t len = 0;
+        while (len < FIXED_KEY_BYTES && bytes[len] != 0) len++;
+        return len;
+    }
+    string_view view() const { return string_view(data(), size()); }
+    string str() const { return string(view()); }
+
+    // <0, 0 or >0 as a orders before, equal to or after b.
+    static int compare(const FixedKey& a, const FixedKey& b) {
+#ifdef FIXED_KEY_SSE2
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.bytes));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.bytes));
+        unsigned diff = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFFu;
+        if (diff == 0) return 0;
+        int i = __builtin_ctz(diff);
+        return (int)a.bytes[i] - (int)b.bytes[i];
+#else
+        return memcmp(a.bytes, b.bytes, FIXED_KEY_BYTES);
+#endif
+    }
+
+    bool operator<(const FixedKey& other) const { return compare(*this, other) < 0; }
+    bool operator==(const FixedKey& other) const { return compare(*this, other) == 0; }
+    bool operator!=(const FixedKey& other) const { return compare(*this, other) != 0; }
+};
+
+inline ostream& operator<<(ostream& out, const FixedKey& key) {
+    return out.write(key.data(), (streamsize)key.size());
+}
+
+#endif //FIXED_KEY_H
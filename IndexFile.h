@@ -0,0 +1,240 @@
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "RecordFile.h"
+#include "FixedKey.h"
+
+using namespace std;
+
+// INDEX FILE FORMAT V2
+// Every base file starts with one 64-byte IndexFileHeader: magic, version, entry width,
+// counts and a checksum of everything after the header. All integers have fixed widths
+// (native little-endian), whatever size_t / long are on the platform.
+//   Primary bases:   count PrimaryIndexRecordV2 {16 key bytes, int64 offset} in key order.
+//                    The records are 8-byte aligned right after the header, so a mapping
+//                    of the file is a sorted array that can be searched in place.
+//   Secondary bases: per key a uint64 length, the key bytes, a uint64 slot count and the
+//                    slots as int64, oldest first.
+//   Ordered bases:   count fixed-width entries as RangeIndexManager stores them.
+// Files are read through a read-only mapping (or one read where mmap is unavailable) and
+// checked against the header before any entry is used.
+// Each checkpoint stamps the bases it writes with the next generation number; the index
+// log records the generation it applies to (see IndexCheckpointer).
+
+const uint32_t INDEX_FILE_VERSION = 2;
+const uint64_t PRIMARY_INDEX_V2_MAGIC = 0x324D495250584449;   // "IDXPRIM2"
+const uint64_t SECONDARY_INDEX_V2_MAGIC = 0x3254534F50584449; // "IDXPOST2"
+
+struct IndexFileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t entryBytes; // Width of one fixed-size entry, or 0 for variable-size bodies
+    uint64_t count;      // Entries (primary, ordered) or keys (secondary)
+    uint64_t refs;       // Slots in a secondary base; equal to count otherwise
+    uint64_t bodyBytes;
+    uint64_t checksum;   // IndexChecksum of the body
+    uint64_t generation; // Checkpoint that wrote the file
+    uint64_t reserved;
+};
+static_assert(sizeof(IndexFileHeader) == 64, "index file header must stay 64 bytes");
+
+struct PrimaryIndexRecordV2 {
+    unsigned char key[FIXED_KEY_BYTES]; // FixedKey bytes, zero-padded
+    int64_t offset;                     // Record slot
+};
+static_assert(sizeof(PrimaryIndexRecordV2) == 24, "primary index record must stay 24 bytes");
+
+// 64-bit checksum over a byte stream, fed in chunks of any size: the stream is taken as
+// 8-byte words, each mixed in with a multiply and rotate.
+class IndexChecksum {
+private:
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    unsigned char pending[8];
+    size_t pendingLen = 0;
+    uint64_t total = 0;
+
+    void mix(uint64_t word) {
+        h ^= word * 0xC2B2AE3D27D4EB4Full;
+        h = ((h << 31) | (h >> 33)) * 0x9E3779B97F4A7C15ull;
+    }
+
+public:
+    void update(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        total += len;
+        while (pendingLen > 0 && len > 0) {
+            pending[pendingLen++] = *p++;
+            len--;
+            if (pendingLen == 8) {
+                uint64_t word;
+                memcpy(&word, pending, 8);
+                mix(word);
+                pendingLen = 0;
+            }
+        }
+        for (; len >= 8; p += 8, len -= 8) {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            mix(word);
+        }
+        memcpy(pending, p, len);
+        pendingLen += len;
+    }
+
+    uint64_t value() const {
+        IndexChecksum last = *this;
+        uint64_t word = 0;
+        memcpy(&word, last.pending, last.pendingLen);
+        last.mix(word ^ total);
+        return last.h ^ (last.h >> 29);
+    }
+};
+
+// Writes a header placeholder, then the body, then patches the header in. The file is
+// on stable storage once finish() returns true, so it can be renamed over a base.
+class IndexFileWriter {
+private:
+    string path;
+    ofstream out;
+    IndexFileHeader header;
+    IndexChecksum sum;
+
+public:
+    IndexFileWriter(const string& filePath, uint64_t magic, uint32_t entryBytes, uint64_t generation)
+        : path(filePath), out(filePath, ios::binary | ios::trunc) {
+        memset(&header, 0, sizeof(header));
+        header.magic = magic;
+        header.version = INDEX_FILE_VERSION;
+        header.entryBytes = entryBytes;
+        header.generation = generation;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    bool good() const { return out.good(); }
+
+    void write(const void* data, size_t len) {
+        out.write(static_cast<const char*>(data), (streamsize)len);
+        sum.update(data, len);
+        header.bodyBytes += len;
+    }
+    void writeU64(uint64_t v) { write(&v, sizeof(v)); }
+
+    bool finish(uint64_t count, uint64_t refs) {
+        header.count = count;
+        header.refs = refs;
+        header.checksum = sum.value();
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (out.fail()) return false;
+        int fd = openDataFd(path);
+        if (fd == -1) return false;
+        bool synced = syncDataFd(fd);
+        closeDataFd(fd);
+        return synced;
+    }
+};
+
+// Generation of a v2 base file; 0 if it is missing, older than v2 or not fully written.
+inline uint64_t indexFileGeneration(const string& path) {
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in.is_open()) return 0;
+    uint64_t bytes = (uint64_t)in.tellg();
+    IndexFileHeader h;
+    in.seekg(0);
+    if (bytes < sizeof(h) || !in.read(reinterpret_cast<char*>(&h), sizeof(h))) return 0;
+    bool v2 = h.version == INDEX_FILE_VERSION && h.bodyBytes == bytes - sizeof(h);
+    return v2 ? h.generation : 0;
+}
+
+// Read-only view of a v2 base file.
+class MappedIndexFile {
+private:
+    string path;
+    const char* base = nullptr;
+    size_t bytes = 0;
+    bool mapped = false;
+    vector<char> copy; // Used where the file cannot be mapped
+
+    void release() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(base), bytes);
+#endif
+        mapped = false;
+        base = nullptr;
+        bytes = 0;
+        copy.clear();
+    }
+
+public:
+    MappedIndexFile() {}
+    MappedIndexFile(const MappedIndexFile&) = delete;
+    MappedIndexFile& operator=(const MappedIndexFile&) = delete;
+    ~MappedIndexFile() { release(); }
+
+    // Maps the file. False if it does not exist or is too short for a header.
+    bool open(const string& file) {
+        release();
+        path = file;
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in.is_open()) return false;
+        bytes = (size_t)in.tellg();
+        if (bytes < sizeof(IndexFileHeader)) return false;
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd != -1) {
+            void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (p != MAP_FAILED) {
+                madvise(p, bytes, MADV_SEQUENTIAL); // Loads read it front to back once
+                base = static_cast<const char*>(p);
+                mapped = true;
+                return true;
+            }
+        }
+#endif
+        copy.resize(bytes);
+        in.seekg(0);
+        if (!in.read(copy.data(), (streamsize)bytes)) return false;
+        base = copy.data();
+        return true;
+    }
+
+    // Magic of the mapped file; older formats are told apart by it before verify().
+    uint64_t magic() const {
+        uint64_t m;
+        memcpy(&m, base, sizeof(m));
+        return m;
+    }
+    const IndexFileHeader& header() const { return *reinterpret_cast<const IndexFileHeader*>(base); }
+    const char* body() const { return base + sizeof(IndexFileHeader); }
+
+    // Checks version, entry width, body length and checksum. A base that fails is
+    // damaged beyond what the log can repair, so this throws.
+    void verify(uint32_t entryBytes) const {
+        const IndexFileHeader& h = header();
+        bool ok = h.version == INDEX_FILE_VERSION && h.entryBytes == entryBytes &&
+                  h.bodyBytes == bytes - sizeof(IndexFileHeader) &&
+                  (entryBytes == 0 || h.bodyBytes == h.count * entryBytes);
+        if (ok) {
+            IndexChecksum sum;
+            sum.update(body(), (size_t)h.bodyBytes);
+            ok = sum.value() == h.checksum;
+        }
+        if (!ok) throw runtime_error("Index file " + path + " is damaged (header or checksum mismatch)");
+    }
+
+    const PrimaryIndexRecordV2* primaryRecords() const {
+        return reinterpret_cast<const PrimaryIndexRecordV2*>(body());
+    }
+};
+
+#endif //INDEX_FILE_H
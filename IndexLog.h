@@ -0,0 +1,455 @@
+#ifndef INDEX_LOG_H
+#define INDEX_LOG_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#include "RecordFile.h"
+#include "IndexFile.h"
+
+using namespace std;
+
+// WRITE-AHEAD LOG FOR INDEX MUTATIONS
+// Every insertPrimary / deletePrimary / insertSecondary / deleteSecondary is appended
+// here as a small binary record, so index changes survive a crash without rewriting
+// the whole index. At load time the log is replayed on top of the saved base files.
+//
+// File layout:
+//   header: magic (u32) | base generation (u64)
+//   record: op (u8) | key length (u16) | key | value (i64) | checksum (u32)
+// The header pins the log to the generation stamped into the base files it applies to.
+// Every checkpoint writes a new generation, so a stale log left behind by a crash is
+// ignored instead of being replayed a second time.
+// A torn record at the tail (crash mid-write) fails its checksum and ends replay.
+// Records are fsynced before the operation that wrote them is acknowledged: on their own,
+// or together at the end of an IndexLogGroup. Callers write and sync the data record
+// first, so the log never points at record bytes that did not reach the disk.
+// The log doubles as the delta file for incremental persistence: the index managers
+// only rewrite their bases in a periodic checkpoint, never on every shutdown.
+
+const uint32_t INDEX_LOG_MAGIC = 0x334C5749; // "IWL3": bound to a base generation
+const size_t CHECKPOINT_MIN_LOG_RECORDS = 50000; // Never checkpoint for fewer deltas than this
+const size_t CHECKPOINT_LOG_RATIO = 4;           // ...or fewer than index entries / ratio
+
+enum class IndexLogOp : uint8_t {
+    InsertPrimary = 1,
+    DeletePrimary = 2,
+    InsertSecondary = 3,
+    DeleteSecondary = 4
+};
+
+struct IndexLogRecord {
+    IndexLogOp op;
+    string key;
+    int64_t value;
+};
+
+class IndexLog;
+
+// GROUP COMMIT
+// One user operation changes several indexes, each with its own log, and may write more
+// than one record to a log. Inside an IndexLogGroup an append only writes its record;
+// commit() then fsyncs each log written since, once, before the operation is
+// acknowledged. Outside a group every append is fsynced on its own.
+class IndexLogGroup {
+private:
+    static inline thread_local IndexLogGroup* current = nullptr;
+    IndexLogGroup* outer;
+    vector<IndexLog*> written;
+
+public:
+    IndexLogGroup() : outer(current) { current = this; }
+    ~IndexLogGroup(); // Syncs what an exception left uncommitted, as far as it can
+
+    IndexLogGroup(const IndexLogGroup&) = delete;
+    IndexLogGroup& operator=(const IndexLogGroup&) = delete;
+
+    // Syncs every log written in the group; throws if one cannot be synced.
+    void commit();
+
+    // Used by IndexLog
+    static bool active() { return current != nullptr; }
+    static void add(IndexLog* log) { current->written.push_back(log); }
+    static void forget(IndexLog* log) {
+        for (IndexLogGroup* g = current; g; g = g->outer) {
+            g->written.erase(remove(g->written.begin(), g->written.end(), log), g->written.end());
+        }
+    }
+};
+
+// Size of an index base file, 0 if it does not exist.
+inline uint64_t indexFileBytes(const string& path) {
+    error_code ec;
+    uintmax_t bytes = filesystem::file_size(path, ec);
+    return ec ? 0 : (uint64_t)bytes;
+}
+
+class IndexLog {
+private:
+    string path;
+    int fd;
+    int64_t writePos;     // End of the last complete record
+    size_t recordCount;   // Records since the last reset
+    vector<char> buffer;  // Scratch space for encoding one record
+    bool unsynced;        // Records written in an IndexLogGroup that has not committed yet
+
+    static const size_t HEADER_BYTES = sizeof(uint32_t) + sizeof(uint64_t);
+
+    static uint32_t checksum(const char* data, size_t len) {
+        uint32_t h = 2166136261u; // FNV-1a
+        for (size_t i = 0; i < len; i++) {
+            h ^= (unsigned char)data[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    void ensureOpen() {
+        if (fd != -1) return;
+        fd = openDataFd(path);
+        if (fd == -1) throw runtime_error("Cannot open index log " + path);
+    }
+
+    void writeHeader(uint64_t generation) {
+        char header[HEADER_BYTES];
+        uint32_t magic = INDEX_LOG_MAGIC;
+        memcpy(header, &magic, sizeof(magic));
+        memcpy(header + 4, &generation, sizeof(generation));
+        if (!pwriteFully(fd, header, HEADER_BYTES, 0)) {
+            throw runtime_error("Failed to write index log header " + path);
+        }
+        writePos = HEADER_BYTES;
+    }
+
+public:
+    explicit IndexLog(const string& logPath)
+        : path(logPath), fd(-1), writePos(0), recordCount(0), unsynced(false) {}
+
+    ~IndexLog() {
+        if (unsynced) {
+            syncDataFd(fd);
+            IndexLogGroup::forget(this);
+        }
+        if (fd != -1) closeDataFd(fd);
+    }
+
+    IndexLog(const IndexLog&) = delete;
+    IndexLog& operator=(const IndexLog&) = delete;
+
+    // Reads the header. Returns false if the log is missing or is not an index log.
+    bool readHeader(uint64_t& generation) {
+        ensureOpen();
+        char header[HEADER_BYTES];
+        if (dataFdSize(fd) < (int64_t)HEADER_BYTES || preadFully(fd, header, HEADER_BYTES, 0) != HEADER_BYTES) {
+            return false;
+        }
+        uint32_t magic;
+        memcpy(&magic, header, sizeof(magic));
+        memcpy(&generation, header + 4, sizeof(generation));
+        return magic == INDEX_LOG_MAGIC;
+    }
+
+    // Reads every intact record after the header. A torn tail is trimmed so new
+    // records continue right after the last good one.
+    vector<IndexLogRecord> readRecords() {
+        ensureOpen();
+        vector<IndexLogRecord> records;
+        int64_t size = dataFdSize(fd);
+        if (size < (int64_t)HEADER_BYTES) return records;
+
+        vector<char> data((size_t)(size - (int64_t)HEADER_BYTES));
+        size_t got = preadFully(fd, data.data(), data.size(), HEADER_BYTES);
+        size_t pos = 0;
+        while (pos + 3 <= got) {
+            uint16_t keyLen;
+            memcpy(&keyLen, &data[pos + 1], sizeof(keyLen));
+            size_t bodyLen = 3 + keyLen + sizeof(int64_t);
+            if (pos + bodyLen + sizeof(uint32_t) > got) break;
+
+            uint32_t stored;
+            memcpy(&stored, &data[pos + bodyLen], sizeof(stored));
+            if (stored != checksum(&data[pos], bodyLen)) break;
+
+            IndexLogRecord rec;
+            rec.op = (IndexLogOp)data[pos];
+            rec.key.assign(&data[pos + 3], keyLen);
+            memcpy(&rec.value, &data[pos + 3 + keyLen], sizeof(rec.value));
+            records.push_back(std::move(rec));
+            pos += bodyLen + sizeof(uint32_t);
+        }
+
+        writePos = (int64_t)HEADER_BYTES + (int64_t)pos;
+        if (writePos < size) truncateDataFd(fd, writePos);
+        recordCount = records.size();
+        return records;
+    }
+
+    void append(IndexLogOp op, string_view key, int64_t value) {
+        ensureOpen();
+        if (writePos == 0) writeHeader(0);
+
+        uint16_t keyLen = (uint16_t)min<size_t>(key.size(), 0xFFFF);
+        size_t bodyLen = 3 + keyLen + sizeof(int64_t);
+        buffer.resize(bodyLen + sizeof(uint32_t));
+        char* buf = buffer.data();
+        buf[0] = (char)op;
+        memcpy(buf + 1, &keyLen, sizeof(keyLen));
+        memcpy(buf + 3, key.data(), keyLen);
+        memcpy(buf + 3 + keyLen, &value, sizeof(value));
+        uint32_t sum = checksum(buf, bodyLen);
+        memcpy(buf + bodyLen, &sum, sizeof(sum));
+
+        if (!pwriteFully(fd, buf, bodyLen + sizeof(sum), writePos)) {
+            throw runtime_error("Failed to append to index log " + path);
+        }
+        writePos += (int64_t)(bodyLen + sizeof(sum));
+        recordCount++;
+        if (!IndexLogGroup::active()) {
+            sync();
+        } else if (!unsynced) {
+            unsynced = true;
+            IndexLogGroup::add(this);
+        }
+    }
+
+    // Forces the records written so far to stable storage.
+    void sync() {
+        if (fd != -1 && !syncDataFd(fd)) throw runtime_error("Failed to sync index log " + path);
+        if (unsynced) {
+            unsynced = false;
+            IndexLogGroup::forget(this);
+        }
+    }
+
+    // Empties the log and binds it to the given base generation.
+    void reset(uint64_t generation) {
+        ensureOpen();
+        if (!truncateDataFd(fd, 0)) throw runtime_error("Failed to truncate index log " + path);
+        writeHeader(generation);
+        sync();
+        recordCount = 0;
+    }
+
+    // Renames the log file; the handle is reopened on the next write.
+    void moveTo(const string& newPath) {
+        if (fd != -1) {
+            sync();
+            closeDataFd(fd);
+            fd = -1;
+        }
+        filesystem::rename(path, newPath);
+        path = newPath;
+        if (!syncParentDir(path)) throw runtime_error("Failed to sync the directory of " + path);
+    }
+
+    void removeFile() {
+        if (unsynced) {
+            unsynced = false;
+            IndexLogGroup::forget(this);
+        }
+        if (fd != -1) {
+            closeDataFd(fd);
+            fd = -1;
+        }
+        error_code ec;
+        filesystem::remove(path, ec);
+        writePos = 0;
+        recordCount = 0;
+    }
+
+    size_t size() const { return recordCount; }
+};
+
+inline void IndexLogGroup::commit() {
+    while (!written.empty()) written.back()->sync(); // sync() takes the log off the list
+}
+
+inline IndexLogGroup::~IndexLogGroup() {
+    try { commit(); } catch (...) {}
+    current = outer;
+}
+
+// INCREMENTAL INDEX PERSISTENCE
+// The log is the delta file; the bases are only rewritten by a checkpoint, which runs
+// once the log holds a fixed fraction of the index. A checkpoint works on a snapshot
+// in a background thread while new deltas go to "<log>.next"; both the new bases and
+// .next carry the next generation, and once the bases are installed .next takes over
+// as the log. Shutdown rewrites nothing, so its cost does not depend on the index size.
+//
+// Crash recovery: the log replays if its generation matches the bases; a leftover .next
+// then continues it (checkpoint not installed yet) or replays on its own against the
+// new bases (installed, old log not removed yet). The old log never matches the new
+// bases, however few bytes the checkpoint changed.
+class IndexCheckpointer {
+private:
+    string primaryPath;
+    string secondaryPath;
+    string logPath;
+    unique_ptr<IndexLog> log;         // Deltas on top of the current bases
+    unique_ptr<IndexLog> pendingLog;  // Deltas since the running checkpoint's snapshot
+    thread worker;
+    atomic<bool> workerDone;
+    bool workerOk;
+    uint64_t generation;              // Generation of the installed bases
+    bool generationKnown;
+    uint64_t leftoverGeneration;      // Generation of a .next found by recover, kept until install
+    bool leftoverNext;
+
+    uint64_t baseGeneration() {
+        if (!generationKnown) {
+            generation = indexFileGeneration(primaryPath);
+            generationKnown = true;
+        }
+        return generation;
+    }
+
+    // Moves the written (and synced) .tmp bases into place, then syncs the directory so
+    // the renames are durable before the caller drops the log they replace. Returns false
+    // if a base could not be renamed. An index with a single base passes an empty
+    // secondary path.
+    bool installBases() {
+        error_code pErr, sErr;
+        filesystem::rename(primaryPath + ".tmp", primaryPath, pErr);
+        if (!secondaryPath.empty()) filesystem::rename(secondaryPath + ".tmp", secondaryPath, sErr);
+        if (!syncParentDir(primaryPath) || (!secondaryPath.empty() && !syncParentDir(secondaryPath))) {
+            throw runtime_error("Failed to sync the directory of " + primaryPath);
+        }
+        return !pErr && !sErr;
+    }
+
+    // installBases renames the primary first. A secondary base behind the primary means
+    // a crash between the two renames; its .tmp was complete before either, so finish it.
+    void completeInstall() {
+        uint64_t gen = baseGeneration();
+        if (secondaryPath.empty() || gen == 0 || indexFileGeneration(secondaryPath) == gen) return;
+        if (indexFileGeneration(secondaryPath + ".tmp") == gen) {
+            error_code ec;
+            filesystem::rename(secondaryPath + ".tmp", secondaryPath, ec);
+        }
+    }
+
+public:
+    IndexCheckpointer(const string& primaryFile, const string& secondaryFile, const string& logFile)
+        : primaryPath(primaryFile), secondaryPath(secondaryFile), logPath(logFile),
+          log(new IndexLog(logFile)), workerDone(false), workerOk(false), generation(0), generationKnown(false),
+          leftoverGeneration(0), leftoverNext(false) {}
+
+    ~IndexCheckpointer() {
+        try { finish(); } catch (...) {}
+    }
+
+    // Reads the deltas to replay over the bases just loaded. Sets needsCheckpoint when
+    // an interrupted checkpoint left two logs behind, so the caller folds them into
+    // fresh bases once replay is done. The leftover .next stays on disk until install()
+    // has put those bases in place.
+    vector<IndexLogRecord> recover(bool& needsCheckpoint) {
+        generationKnown = false;
+        completeInstall();
+        uint64_t gen = baseGeneration();
+        uint64_t logGen;
+        vector<IndexLogRecord> records;
+        bool logValid = log->readHeader(logGen) && logGen == gen;
+        if (logValid) records = log->readRecords();
+
+        needsCheckpoint = filesystem::exists(logPath + ".next");
+        if (needsCheckpoint) {
+            IndexLog next(logPath + ".next");
+            leftoverNext = true;
+            leftoverGeneration = 0;
+            if (next.readHeader(logGen)) {
+                leftoverGeneration = logGen;
+                if (logGen == (logValid ? gen + 1 : gen)) {
+                    vector<IndexLogRecord> more = next.readRecords();
+                    records.insert(records.end(), make_move_iterator(more.begin()), make_move_iterator(more.end()));
+                }
+            }
+        } else if (!logValid) {
+            log->reset(gen); // Stale or missing log; the bases already hold it
+        }
+        return records;
+    }
+
+    void append(IndexLogOp op, string_view key, int64_t value) {
+        (pendingLog ? pendingLog : log)->append(op, key, value);
+    }
+
+    // Installs a finished background checkpoint, then reports whether enough deltas
+    // have piled up to start another one.
+    bool due(size_t indexEntries) {
+        if (worker.joinable()) {
+            if (!workerDone) return false;
+            finish();
+        }
+        return log->size() >= max(CHECKPOINT_MIN_LOG_RECORDS, indexEntries / CHECKPOINT_LOG_RATIO);
+    }
+
+    // Starts a background checkpoint. writeTmpBases writes "<base>.tmp" for both
+    // bases, stamped with the generation it is given, from a snapshot the caller
+    // captured, and returns false on failure.
+    void start(function<bool(uint64_t)> writeTmpBases) {
+        uint64_t next = baseGeneration() + 1;
+        pendingLog.reset(new IndexLog(logPath + ".next"));
+        pendingLog->reset(next);
+        workerDone = false;
+        worker = thread([this, next, write = std::move(writeTmpBases)]() {
+            workerOk = write(next);
+            workerDone = true;
+        });
+    }
+
+    // Waits for a running checkpoint and installs it.
+    void finish() {
+        if (!worker.joinable()) return;
+        worker.join();
+        if (workerOk && installBases()) {
+            generation++;
+            log->removeFile();
+            pendingLog->moveTo(logPath);
+            log = std::move(pendingLog);
+            return;
+        }
+        // The checkpoint failed: keep the old bases and fold its deltas back into the log
+        for (const auto& rec : pendingLog->readRecords()) log->append(rec.op, rec.key, rec.value);
+        pendingLog->removeFile();
+        pendingLog.reset();
+    }
+
+    // Synchronous checkpoint of the caller's live state: writeTmpBases writes the .tmp
+    // bases stamped with the generation it is given and says whether that succeeded.
+    // After a recovery the new bases hold the records of the leftover .next as well, so
+    // they skip past its generation: a crash before .next is removed must not replay it.
+    void install(const function<bool(uint64_t)>& writeTmpBases) {
+        uint64_t next = max(baseGeneration(), leftoverNext ? leftoverGeneration : 0) + 1;
+        if (writeTmpBases(next) && installBases()) {
+            generation = next;
+            log->reset(next);
+            if (leftoverNext) {
+                IndexLog(logPath + ".next").removeFile();
+                leftoverNext = false;
+            }
+        } else if (leftoverNext) {
+            throw runtime_error("Cannot checkpoint the recovered index log " + logPath);
+        }
+    }
+
+    // Generations of the bases and the size of the log, used to tell whether a mirror
+    // of the index (the primary B+ tree, the filter) still matches them.
+    void fingerprint(uint64_t out[3]) const {
+        out[0] = indexFileGeneration(primaryPath);
+        out[1] = indexFileGeneration(secondaryPath);
+        out[2] = indexFileBytes(logPath);
+    }
+
+    size_t pendingDeltas() const { return log->size() + (pendingLog ? pendingLog->size() : 0); }
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <unordered_map>
 #include <cstring>
@@ -12,22 +13,65 @@
 #include <sstream>
 #include <iterator>
 #include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+
+#include "IndexLog.h"
+#include "BPlusTree.h"
+#include "OrderedIndex.h"
+#include "PostingsIndex.h"
+#include "BloomFilter.h"
+#include "FixedKey.h"
+#include "EytzingerIndex.h"
+#include "IndexFile.h"
+#include "RangeIndex.h"
+#include "RadixIndex.h"
 
 using namespace std;
 
 // Appointment Constants
 const string APPT_PRIMARY_INDEX_FILE = "primary.idx";
 const string APPT_SECONDARY_INDEX_FILE = "secondary.idx";
+const string APPT_INDEX_LOG_FILE = "index.wal";
+const string APPT_PRIMARY_TREE_FILE = "primary.bpt";
+const string APPT_PRIMARY_FILTER_FILE = "primary.bloom";
+const string APPT_DATE_INDEX_FILE = "date.idx";
+const string APPT_DATE_INDEX_LOG_FILE = "date_index.wal";
+const string APPT_PATIENT_INDEX_FILE = "patient.idx";
+const string APPT_PATIENT_INDEX_LOG_FILE = "patient_index.wal";
+const string APPT_DOCTOR_DAY_INDEX_FILE = "doctor_day.idx";
+const string APPT_DOCTOR_DAY_INDEX_LOG_FILE = "doctor_day_index.wal";
 
 // Doctor Constants
 const string DOC_PRIMARY_INDEX_FILE = "doctor_primary.idx";
 const string DOC_SECONDARY_INDEX_FILE = "doctor_secondary.idx";
+const string DOC_INDEX_LOG_FILE = "doctor_index.wal";
+const string DOC_PRIMARY_TREE_FILE = "doctor_primary.bpt";
+const string DOC_PRIMARY_FILTER_FILE = "doctor_primary.bloom";
 
 
+// Primary index container for both managers. OrderedIndex (a counted in-memory B+ tree)
+// keeps insertPrimary / deletePrimary at O(log n); build with -DPRIMARY_INDEX_SORTED_VECTOR
+// to go back to the original sorted vector.
+#ifdef PRIMARY_INDEX_SORTED_VECTOR
+template <class Entry> using PrimaryIndexStore = SortedVector<Entry>;
+#else
+template <class Entry> using PrimaryIndexStore = OrderedIndex<Entry>;
+#endif
+
+// Base files are written in the v2 format (IndexFile.h). Bases in the original format are
+// converted when loaded: v1 primary bases are parsed, and secondary bases (linked nodes of
+// primary positions) are rebuilt from the records (see rebuildSecondaryFromRecords).
+
+// Primary records buffered per write when saving a base
+const size_t INDEX_WRITE_BATCH_RECORDS = 4096;
+
 // --- Appointment Index Structures ---
 
 struct ApptPrimaryIndexEntry {
-    string appointmentId; // Primary Key
+    FixedKey appointmentId; // Primary Key, inline and zero-padded
     long offset;          // File offset (record position)
 
     bool operator<(const ApptPrimaryIndexEntry& other) const {
@@ -35,470 +79,588 @@ struct ApptPrimaryIndexEntry {
     }
 };
 
-struct ApptSecondaryIndexNode {
-    string doctorId; // Secondary Key
-    int primaryIndexPos; // Index into the primaryIndex vector
-    int next;            // Index of the next node in the secondary index list
-
-    ApptSecondaryIndexNode(const string& id, int pos)
-        : doctorId(id), primaryIndexPos(pos), next(-1) {}
-};
-
 // --- Doctor Index Structures ---
 
 struct DocPrimaryIndexEntry {
-    string doctorId;
-    short offset; // File offset in bytes
+    FixedKey doctorId;
+    long offset; // Record slot
 
     bool operator<(const DocPrimaryIndexEntry& other) const {
         return doctorId < other.doctorId;
     }
 };
 
-struct DocSecondaryIndexNode {
-    string doctorName; // Secondary Key
-    int primaryIndexPos; // Index into the primaryIndex vector
-    int next;            // Index of the next node in the secondary index list
+// --- Index Traits ---
+// Compile-time policies for IndexManager:
+//   Entry    primary index entry, aggregate-initialized as {key, offset}
+//   Offset   record slot type (v2 base files store slots as int64 whatever it is)
+//   LegacyOffset  width of a slot in v1 primary bases, read when converting them (long
+//            for appointments; short for doctors, which widened to long in v2)
+//   key(e)   the entry's key, encoded as a zero-padded FixedKey
+//   *File()  base files, log, B+ tree mirror and Bloom filter
+
+struct AppointmentIndexTraits {
+    typedef ApptPrimaryIndexEntry Entry;
+    typedef long Offset;
+    typedef long LegacyOffset;
+    static const FixedKey& key(const Entry& e) { return e.appointmentId; }
+    static const string& primaryFile() { return APPT_PRIMARY_INDEX_FILE; }
+    static const string& secondaryFile() { return APPT_SECONDARY_INDEX_FILE; }
+    static const string& logFile() { return APPT_INDEX_LOG_FILE; }
+    static const string& treeFile() { return APPT_PRIMARY_TREE_FILE; }
+    static const string& filterFile() { return APPT_PRIMARY_FILTER_FILE; }
+};
 
-    DocSecondaryIndexNode(const string& name, int pos)
-        : doctorName(name), primaryIndexPos(pos), next(-1) {}
+struct DoctorIndexTraits {
+    typedef DocPrimaryIndexEntry Entry;
+    typedef long Offset;
+    typedef short LegacyOffset;
+    static const FixedKey& key(const Entry& e) { return e.doctorId; }
+    static const string& primaryFile() { return DOC_PRIMARY_INDEX_FILE; }
+    static const string& secondaryFile() { return DOC_SECONDARY_INDEX_FILE; }
+    static const string& logFile() { return DOC_INDEX_LOG_FILE; }
+    static const string& treeFile() { return DOC_PRIMARY_TREE_FILE; }
+    static const string& filterFile() { return DOC_PRIMARY_FILTER_FILE; }
 };
 
-//  APPOINTMENT MANAGER
+//  INDEX MANAGER
+// One primary index (unique FixedKey -> record slot) and one secondary index (key ->
+// record slots) over the same data file, with their log, checkpoints, tree mirror,
+// filter and search snapshot. Traits fixes the entry type, slot width and files.
+
+template <class Traits>
+class IndexManager {
+public:
+    typedef typename Traits::Entry Entry;
+    typedef typename Traits::Offset Offset;
 
-class AppointmentIndexManager {
 private:
-    vector<ApptPrimaryIndexEntry> primaryIndex;
-    vector<ApptSecondaryIndexNode> secondaryIndex;
-    unordered_map<string, int> secondaryIndexHeads;
-
-    // Adjusts primaryIndexPos pointers in secondary index after erasure.
-    void updateSecondaryIndicesOnErase(int deletedPos) {
-        for (auto& node : secondaryIndex) {
-            if (node.primaryIndexPos > deletedPos) {
-                node.primaryIndexPos--;
-            }
+    PrimaryIndexStore<Entry> primaryIndex;
+    PostingsIndex<Offset> secondaryIndex;
+    IndexCheckpointer checkpointer;
+    BPlusTree primaryTree;  // On-disk mirror of primaryIndex
+    BloomFilter primaryFilter; // Answers most lookups of IDs that are not in primaryIndex
+    bool logSuppressed; // Set during a bulk change that ends in a checkpoint
+
+    // Each index is loaded on first use (or by the prefetch thread); loads take loadMutex
+    atomic<bool> primaryLoaded;
+    atomic<bool> secondaryLoaded;
+    mutex loadMutex;
+    bool logRecovered;                  // Log read; records for an index not loaded yet wait in pendingLog
+    bool rewritePending;                // The bases must be rewritten before either index is used
+    vector<IndexLogRecord> pendingLog;
+    exception_ptr loadError;            // A failed load, rethrown by every later access
+    thread prefetcher;
+    uint64_t openFingerprint[3];        // File sizes at startup, which the tree and filter were checked against
+    bool treeStale;     // The tree did not match the files at startup; rebuilt once primaryIndex is loaded
+    bool filterChecked; // The filter file is read on the first primary lookup
+    bool filterStale;
+
+    Entry treeHit; // What searchByPrimary returns while only the tree is open
+    EytzingerIndex<Entry> searchSnapshot; // Read-optimized copy of primaryIndex
+    RadixIndex<Offset> secondaryPrefix; // Case-folded copy of secondaryIndex for prefix searches
+    bool prefixBuilt;   // secondaryPrefix is built on first use and kept in step afterwards
+
+    // Secondary keys of the records at the given slots, read from the data file
+    function<vector<string>(const vector<Offset>&)> readSecondaryKeys;
+
+    // Loads v2 bases straight from their mapping. Bases in an older format are parsed
+    // with the old readers; loadPart rewrites them as v2 (the converter).
+    void loadPrimaryBase() {
+        MappedIndexFile pFile;
+        if (pFile.open(Traits::primaryFile()) && pFile.magic() == PRIMARY_INDEX_V2_MAGIC) {
+            pFile.verify(sizeof(PrimaryIndexRecordV2));
+            // Records are copied from the mapping into the store, with no per-entry parsing.
+            // The store is not served from the mapping itself: it takes inserts and deletes
+            // in place, hands out ranks, and checkpoints copy it while the next base replaces
+            // the mapped file. Lookups made before this load go to the tree mirror instead.
+            const PrimaryIndexRecordV2* records = pFile.primaryRecords();
+            primaryIndex.assign(pFile.header().count, [records](size_t i) {
+                return Entry{FixedKey::fromBytes(records[i].key), (Offset)records[i].offset};
+            });
+        } else {
+            loadPrimaryV1();
+        }
+    }
+
+    void loadSecondaryBase() {
+        MappedIndexFile sFile;
+        if (sFile.open(Traits::secondaryFile()) && sFile.magic() == SECONDARY_INDEX_V2_MAGIC) {
+            sFile.verify(0);
+            secondaryIndex.read(sFile.body(), sFile.header().bodyBytes, sFile.header().count);
+        } else if (filesystem::exists(Traits::secondaryFile())) {
+            rebuildSecondaryFromRecords();
         }
     }
 
-    void loadIndexes() {
-        // Load Primary Index
-        ifstream pIn(APPT_PRIMARY_INDEX_FILE, ios::binary);
+    // First format: size_t count, then per entry a size_t key length, the key and a LegacyOffset.
+    void loadPrimaryV1() {
+        ifstream pIn(Traits::primaryFile(), ios::binary);
         if (pIn.is_open()) {
             size_t sz;
 
+            vector<Entry> entries;
             if (pIn.read(reinterpret_cast<char*>(&sz), sizeof(sz))) {
-                primaryIndex.reserve(sz);
+                entries.reserve(sz);
                 for (size_t i = 0; i < sz; i++) {
                     size_t len;
                     if (!pIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
                     string key(len, '\0');
                     if (!pIn.read(&key[0], len)) break;
-                    long offset;
+                    typename Traits::LegacyOffset offset;
                     if (!pIn.read(reinterpret_cast<char*>(&offset), sizeof(offset))) break;
-                    primaryIndex.push_back({key, offset});
+                    entries.push_back({key, (Offset)offset});
                 }
             }
+            primaryIndex.assign(std::move(entries));
         }
+    }
 
-        // Load Secondary Index (Heads and Nodes)
-        ifstream sIn(APPT_SECONDARY_INDEX_FILE, ios::binary);
-        if (sIn.is_open()) {
-            size_t headsCount;
-            if (sIn.read(reinterpret_cast<char*>(&headsCount), sizeof(headsCount))) {
-                for (size_t i = 0; i < headsCount; i++) {
-                    size_t len;
-                    if (!sIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
-                    string key(len, '\0');
-                    if (!sIn.read(&key[0], len)) break;
-                    int head;
-                    if (!sIn.read(reinterpret_cast<char*>(&head), sizeof(head))) break;
-                    secondaryIndexHeads[key] = head;
-                }
-            }
-
-            size_t nodesCount;
-            if (sIn.read(reinterpret_cast<char*>(&nodesCount), sizeof(nodesCount))) {
-                secondaryIndex.reserve(nodesCount);
-                for (size_t i = 0; i < nodesCount; i++) {
-                    size_t len;
-                    if (!sIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
-                    string id(len, '\0');
-                    if (!sIn.read(&id[0], len)) break;
-                    int pos, next;
-                    if (!sIn.read(reinterpret_cast<char*>(&pos), sizeof(pos))) break;
-                    if (!sIn.read(reinterpret_cast<char*>(&next), sizeof(next))) break;
-
-                    ApptSecondaryIndexNode newNode(id, pos);
-                    newNode.next = next;
-                    secondaryIndex.push_back(std::move(newNode));
-                }
-            }
+    // The original secondary format linked nodes to positions in the primary index, which
+    // went stale whenever an insert landed before them. Such a base is not read at all:
+    // the index is rebuilt from the secondary key stored in each indexed record.
+    void rebuildSecondaryFromRecords() {
+        if (!readSecondaryKeys) {
+            throw runtime_error("Cannot convert " + Traits::secondaryFile() + " without its data file");
         }
+        vector<Offset> slots;
+        slots.reserve(primaryIndex.size());
+        for (const auto& e : primaryIndex) slots.push_back(e.offset);
+        sort(slots.begin(), slots.end()); // File order, oldest record first
+        vector<string> keys = readSecondaryKeys(slots);
+        secondaryIndex.clear();
+        secondaryIndex.reserve(slots.size());
+        for (size_t i = 0; i < slots.size(); i++) secondaryIndex.insert(keys[i], slots[i]);
     }
 
-    void saveIndexes() {
-        // Save Primary Index
-        ofstream pOut(APPT_PRIMARY_INDEX_FILE, ios::binary | ios::trunc);
-        if (pOut.good()) {
-            size_t sz = primaryIndex.size();
-            pOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& p : primaryIndex) {
-                size_t len = p.appointmentId.size();
-                pOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                pOut.write(p.appointmentId.c_str(), len);
-                pOut.write(reinterpret_cast<const char*>(const_cast<long*>(&p.offset)), sizeof(p.offset));
+    // Whether file holds a base in an older format, which has to be converted
+    static bool isLegacyBase(const string& file, uint64_t v2Magic) {
+        ifstream in(file, ios::binary);
+        if (!in.is_open()) return false;
+        uint64_t magic = 0;
+        in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return magic != v2Magic;
+    }
+
+    // Re-applies the logged mutations of one index. The tree and filter already
+    // mirror them, so only the in-memory index changes.
+    void replayLog(bool primary) {
+        for (const auto& rec : pendingLog) {
+            switch (rec.op) {
+                case IndexLogOp::InsertPrimary:
+                    if (primary) primaryIndex.insert(Entry{rec.key, (Offset)rec.value});
+                    break;
+                case IndexLogOp::DeletePrimary:
+                    if (primary) primaryIndex.erase(Entry{rec.key, 0});
+                    break;
+                case IndexLogOp::InsertSecondary:
+                    if (!primary) secondaryIndex.insert(rec.key, (Offset)rec.value);
+                    break;
+                case IndexLogOp::DeleteSecondary:
+                    if (!primary) secondaryIndex.erase(rec.key, (Offset)rec.value);
+                    break;
             }
-        } else {
-             // Handle error if file can't be opened/written
         }
+    }
 
-        // Save Secondary Index Heads and Nodes
-        ofstream sOut(APPT_SECONDARY_INDEX_FILE, ios::binary | ios::trunc);
-        if (sOut.good()) {
-            size_t sz = secondaryIndexHeads.size();
-            sOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& entry : secondaryIndexHeads) {
-                size_t len = entry.first.size();
-                sOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                sOut.write(entry.first.c_str(), len);
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&entry.second)), sizeof(entry.second));
+    // Loads one index and its share of the log, on the caller's thread or the prefetch
+    // thread. The first load recovers the log. If the bases must be rewritten (crash
+    // recovery, or an older format) both indexes are loaded and saved together; that may
+    // read records through the shared buffer pool, so the prefetch thread leaves it to
+    // the first caller on the main thread.
+    void loadPart(bool primary, bool prefetching = false) {
+        lock_guard<mutex> lock(loadMutex);
+        if (loadError) rethrow_exception(loadError);
+        if (primary ? primaryLoaded : secondaryLoaded) return;
+        try {
+            if (!logRecovered) {
+                bool needsCheckpoint;
+                pendingLog = checkpointer.recover(needsCheckpoint);
+                logRecovered = true;
+                rewritePending = needsCheckpoint || isLegacyBase(Traits::primaryFile(), PRIMARY_INDEX_V2_MAGIC) ||
+                                 isLegacyBase(Traits::secondaryFile(), SECONDARY_INDEX_V2_MAGIC);
             }
-
-            sz = secondaryIndex.size();
-            sOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& node : secondaryIndex) {
-                size_t len = node.doctorId.size();
-                sOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                sOut.write(node.doctorId.c_str(), len);
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&node.primaryIndexPos)), sizeof(node.primaryIndexPos));
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&node.next)), sizeof(node.next));
+            if (rewritePending) {
+                if (prefetching) return;
+                // Linked secondary bases may refer to primary positions before the log
+                loadPrimaryBase();
+                loadSecondaryBase();
+                replayLog(true);
+                replayLog(false);
+                saveIndexes();
+                rewritePending = false;
+                primaryLoaded = true;
+                secondaryLoaded = true;
+            } else if (primary) {
+                loadPrimaryBase();
+                replayLog(true);
+                primaryLoaded = true;
+            } else {
+                loadSecondaryBase();
+                replayLog(false);
+                secondaryLoaded = true;
             }
+            if (primaryLoaded && secondaryLoaded) vector<IndexLogRecord>().swap(pendingLog);
+        } catch (...) {
+            loadError = current_exception();
+            throw;
         }
     }
 
-
-public:
-    AppointmentIndexManager() { loadIndexes(); }
-    ~AppointmentIndexManager() { saveIndexes(); }
-
-    // Binary Search Implementation
-    // Returns index in primaryIndex vector, or -1 if not found.
-    int binarySearchPrimary(const string& appointmentId) const {
-        int left = 0;
-        int right = (int)primaryIndex.size() - 1;
-        while (left <= right) {
-            int mid = left + (right - left) / 2;
-            if (primaryIndex[mid].appointmentId == appointmentId) return mid;
-            else if (primaryIndex[mid].appointmentId < appointmentId) left = mid + 1;
-            else right = mid - 1;
+    // Writes full base files to "<base>.tmp"; the checkpointer renames them into place,
+    // so a crash never leaves a half-written base. Runs on the checkpoint thread, so it
+    // only touches the snapshot it is given.
+    static bool writeBaseFiles(const PrimaryIndexStore<Entry>& primary, const PostingsIndex<Offset>& postings,
+                               uint64_t generation) {
+        // Save Primary Index: fixed-width records in key order, written in batches
+        IndexFileWriter pOut(Traits::primaryFile() + ".tmp", PRIMARY_INDEX_V2_MAGIC, sizeof(PrimaryIndexRecordV2),
+                             generation);
+        vector<PrimaryIndexRecordV2> batch;
+        batch.reserve(INDEX_WRITE_BATCH_RECORDS);
+        for (const auto& p : primary) {
+            PrimaryIndexRecordV2 r;
+            memcpy(r.key, Traits::key(p).bytes, sizeof(r.key));
+            r.offset = (int64_t)p.offset;
+            batch.push_back(r);
+            if (batch.size() == INDEX_WRITE_BATCH_RECORDS) {
+                pOut.write(batch.data(), batch.size() * sizeof(PrimaryIndexRecordV2));
+                batch.clear();
+            }
         }
-        return -1;
+        pOut.write(batch.data(), batch.size() * sizeof(PrimaryIndexRecordV2));
+
+        // Save Secondary Index, one block per key
+        IndexFileWriter sOut(Traits::secondaryFile() + ".tmp", SECONDARY_INDEX_V2_MAGIC, 0, generation);
+        postings.write(sOut);
+
+        bool pOk = pOut.finish(primary.size(), primary.size());
+        bool sOk = sOut.finish(postings.keyCount(), postings.size());
+        return pOk && sOk;
     }
-    // Inserts an entry and returns its new position.
-    int insertPrimary(const string& appointmentId, long offset) {
-        ApptPrimaryIndexEntry newEntry{appointmentId, offset};
-        auto it = std::lower_bound(primaryIndex.begin(), primaryIndex.end(), newEntry);
-        int pos = std::distance(primaryIndex.begin(), it);
-        primaryIndex.insert(it, newEntry);
-        return pos;
+
+    // Reads the filter file against the files as they were at startup. Primary
+    // mutations load it first, so it still holds every key.
+    void ensureFilterLoaded() {
+        if (filterChecked) return;
+        filterChecked = true;
+        filterStale = !primaryFilter.load(Traits::filterFile(), openFingerprint);
     }
 
-    // Updates Primary Index on delete
-    // Deletes an entry and returns its old position for secondary index maintenance.
-    int deletePrimary(const string& appointmentId) {
-        ApptPrimaryIndexEntry tempEntry{appointmentId, 0};
-        auto it = std::lower_bound(primaryIndex.begin(), primaryIndex.end(), tempEntry);
+    // Loads primaryIndex on first use; mirrors that did not match at startup are then
+    // rebuilt here, on the thread that owns them.
+    void ensurePrimaryLoaded() {
+        if (!primaryLoaded) loadPart(true);
+        ensureFilterLoaded();
+        if (treeStale) {
+            rebuildTree();
+            treeStale = false;
+        }
+        if (filterStale) {
+            rebuildFilter();
+            filterStale = false;
+        }
+    }
 
-        if (it != primaryIndex.end() && it->appointmentId == appointmentId) {
-            int deletedPos = std::distance(primaryIndex.begin(), it);
-            primaryIndex.erase(it);
+    void ensureSecondaryLoaded() {
+        if (!secondaryLoaded) loadPart(false);
+    }
 
-            // Crucial step: Update secondary index pointers
-            updateSecondaryIndicesOnErase(deletedPos);
-            return deletedPos;
-        }
-        return -1; // Not found
+    // Mutations are logged against both bases, and checkpoints write both
+    void ensureLoaded() {
+        ensurePrimaryLoaded();
+        ensureSecondaryLoaded();
     }
 
-    // Linked-List Secondary Index Management
-    // Inserts a new node and binds it to the primary index position.
-    void insertSecondary(const string& doctorId, int primaryIndexPos) {
-        ApptSecondaryIndexNode newNode(doctorId, primaryIndexPos);
-        int newNodeIdx = (int)secondaryIndex.size();
-        secondaryIndex.push_back(newNode);
+    void rebuildTree() {
+        primaryTree.bulkLoad(primaryIndex,
+                             [](const Entry& e) { return Traits::key(e).view(); },
+                             [](const Entry& e) { return (int64_t)e.offset; });
+    }
 
-        auto head_it = secondaryIndexHeads.find(doctorId);
-        if (head_it == secondaryIndexHeads.end()) {
-            secondaryIndexHeads[doctorId] = newNodeIdx;
-        } else {
-            // Prepend: New node points to old head
-            secondaryIndex[newNodeIdx].next = head_it->second;
-            // New node becomes the new head
-            head_it->second = newNodeIdx;
-        }
+    void rebuildFilter() {
+        primaryFilter.build(primaryIndex, primaryIndex.size(), [](const Entry& e) { return Traits::key(e).view(); });
     }
 
-    // Linked-List Secondary Index Deletion
-    void deleteSecondary(const string& doctorId, int primaryIndexPos) {
-        auto head_it = secondaryIndexHeads.find(doctorId);
-        if (head_it == secondaryIndexHeads.end()) return;
+    void rebuildSnapshot() {
+        searchSnapshot.build(primaryIndex, [](const Entry& e) -> const FixedKey& { return Traits::key(e); });
+    }
 
-        int currentIdx = head_it->second;
-        int prevIdx = -1;
+    void ensurePrefixIndex() {
+        ensureSecondaryLoaded();
+        if (prefixBuilt) return;
+        prefixBuilt = true;
+        secondaryPrefix.clear();
+        secondaryIndex.forEachEntry([this](string_view key, Offset slot) { secondaryPrefix.insert(key, slot); });
+    }
 
-        while (currentIdx != -1) {
-            if (secondaryIndex[currentIdx].primaryIndexPos == primaryIndexPos) {
-                if (prevIdx == -1) {
-                    // Deleted node is the head
-                    head_it->second = secondaryIndex[currentIdx].next;
-                    if (head_it->second == -1) secondaryIndexHeads.erase(head_it);
-                } else {
-                    // Deleted node is in the middle/end
-                    secondaryIndex[prevIdx].next = secondaryIndex[currentIdx].next;
-                }
-                // Node is logically unlinked; physical removal from vector is a separate defragmentation task.
-                break;
-            }
-            prevIdx = currentIdx;
-            currentIdx = secondaryIndex[currentIdx].next;
-        }
+    // Synchronous checkpoint of the live indexes (bulk changes and crash recovery).
+    void saveIndexes() {
+        checkpointer.finish();
+        checkpointer.install([this](uint64_t generation) {
+            return writeBaseFiles(primaryIndex, secondaryIndex, generation);
+        });
     }
 
-    // --- Access/Search Methods ---
-    // Retrieves a single primary index entry by primary key
-    const ApptPrimaryIndexEntry* searchByPrimary(const string& appointmentId) const {
-        int pos = binarySearchPrimary(appointmentId);
-        if (pos != -1) return &primaryIndex[pos];
-        return nullptr;
-    }
-
-    // Retrieves all primary index entries for a given secondary key
-    vector<const ApptPrimaryIndexEntry*> searchBySecondary(const string& doctorId) const {
-        vector<const ApptPrimaryIndexEntry*> results;
-        auto head_it = secondaryIndexHeads.find(doctorId);
-        if (head_it == secondaryIndexHeads.end()) return results;
-
-        int currentIdx = head_it->second;
-        while (currentIdx != -1) {
-            int primaryPos = secondaryIndex[currentIdx].primaryIndexPos;
-            results.push_back(&primaryIndex[primaryPos]);
-            currentIdx = secondaryIndex[currentIdx].next;
+    // Logs one mutation and, once enough have piled up, starts a background checkpoint
+    // of a snapshot of the indexes.
+    void logMutation(IndexLogOp op, string_view key, int64_t value) {
+        if (logSuppressed) return;
+        ensureLoaded();
+        checkpointer.append(op, key, value);
+        if (checkpointer.due(primaryIndex.size())) {
+            checkpointer.start([primary = primaryIndex, postings = secondaryIndex](uint64_t generation) {
+                return writeBaseFiles(primary, postings, generation);
+            });
         }
-        return results;
     }
-};
 
-// DOCTOR MANAGER
+public:
+    // Startup reads nothing but the tree header: each index is loaded on first use,
+    // and primary lookups are served from the tree until then if it was closed cleanly.
+    // secondaryKeys reads the secondary key of each record slot it is given; it is only
+    // needed to convert a base in the original secondary format.
+    explicit IndexManager(function<vector<string>(const vector<Offset>&)> secondaryKeys = nullptr)
+        : checkpointer(Traits::primaryFile(), Traits::secondaryFile(), Traits::logFile()), primaryTree(Traits::treeFile()),
+          logSuppressed(false), primaryLoaded(false), secondaryLoaded(false), logRecovered(false), rewritePending(false),
+          filterChecked(false), filterStale(false), prefixBuilt(false), readSecondaryKeys(std::move(secondaryKeys)) {
+        checkpointer.fingerprint(openFingerprint);
+        treeStale = !primaryTree.open(openFingerprint);
+    }
+    ~IndexManager() {
+        if (prefetcher.joinable()) prefetcher.join();
+        checkpointer.finish();
+        uint64_t fingerprint[3];
+        checkpointer.fingerprint(fingerprint);
+        // A tree never rebuilt keeps its header, which does not match the files
+        if (!treeStale) primaryTree.close(fingerprint);
+        // An unread filter file stays valid until the files change under it
+        if (!filterChecked && memcmp(fingerprint, openFingerprint, sizeof(fingerprint)) != 0) ensureFilterLoaded();
+        primaryFilter.save(Traits::filterFile(), fingerprint);
+    }
 
-class DoctorIndexManager {
-private:
-    vector<DocPrimaryIndexEntry> primaryIndex;
-    vector<DocSecondaryIndexNode> secondaryIndex;
-    unordered_map<string, int> secondaryIndexHeads;
-
-    // Adjusts primaryIndexPos pointers in secondary index after erasure.
-    void updateSecondaryIndicesOnErase(int deletedPos) {
-        for (auto& node : secondaryIndex) {
-            if (node.primaryIndexPos > deletedPos) {
-                node.primaryIndexPos--;
+    // Loads both indexes on a worker thread, so the first query need not wait for them.
+    // A failure is kept and rethrown by the first access to the index.
+    void startPrefetch() {
+        if (prefetcher.joinable()) return;
+        prefetcher = thread([this]() {
+            try {
+                loadPart(true, true);
+                loadPart(false, true);
+            } catch (...) {
+                // Recorded in loadError
             }
-        }
+        });
     }
 
-    void loadIndexes() {
-        // Load Primary Index (using short offset)
-        ifstream pIn(DOC_PRIMARY_INDEX_FILE, ios::binary);
-        if (pIn.is_open()) {
-            size_t sz;
-            if (pIn.read(reinterpret_cast<char*>(&sz), sizeof(sz))) {
-                primaryIndex.reserve(sz);
-                for (size_t i = 0; i < sz; i++) {
-                    size_t len;
-                    if (!pIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
-                    string key(len, '\0');
-                    if (!pIn.read(&key[0], len)) break;
-                    short offset;
-                    if (!pIn.read(reinterpret_cast<char*>(&offset), sizeof(offset))) break;
-                    primaryIndex.push_back({key, offset});
-                }
-            }
+    // Returns the position (rank) of primaryKey in primaryIndex, or -1 if not found.
+    int binarySearchPrimary(string_view primaryKey) {
+        ensurePrimaryLoaded();
+        return (int)primaryIndex.find(Entry{primaryKey, 0});
+    }
+    // Inserts an entry and returns its new position.
+    int insertPrimary(string_view primaryKey, Offset offset) {
+        ensurePrimaryLoaded();
+        int pos = (int)primaryIndex.insert(Entry{primaryKey, offset});
+        searchSnapshot.invalidate();
+        if (!logSuppressed) {
+            primaryTree.insert(primaryKey, offset);
+            primaryFilter.add(primaryKey);
+            if (primaryFilter.needsRebuild()) rebuildFilter();
         }
+        logMutation(IndexLogOp::InsertPrimary, primaryKey, offset);
+        return pos;
+    }
 
-        // Load Secondary Index (Heads and Nodes)
-        ifstream sIn(DOC_SECONDARY_INDEX_FILE, ios::binary);
-        if (sIn.is_open()) {
-            size_t headsCount;
-            if (sIn.read(reinterpret_cast<char*>(&headsCount), sizeof(headsCount))) {
-                for (size_t i = 0; i < headsCount; i++) {
-                    size_t len;
-                    if (!sIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
-                    string key(len, '\0');
-                    if (!sIn.read(&key[0], len)) break;
-                    int head;
-                    if (!sIn.read(reinterpret_cast<char*>(&head), sizeof(head))) break;
-                    secondaryIndexHeads[key] = head;
-                }
-            }
-            size_t nodesCount;
-            if (sIn.read(reinterpret_cast<char*>(&nodesCount), sizeof(nodesCount))) {
-                secondaryIndex.reserve(nodesCount);
-                for (size_t i = 0; i < nodesCount; i++) {
-                    size_t len;
-                    if (!sIn.read(reinterpret_cast<char*>(&len), sizeof(len))) break;
-                    string name(len, '\0');
-                    if (!sIn.read(&name[0], len)) break;
-                    int pos, next;
-                    if (!sIn.read(reinterpret_cast<char*>(&pos), sizeof(pos))) break;
-                    if (!sIn.read(reinterpret_cast<char*>(&next), sizeof(next))) break;
-
-                    DocSecondaryIndexNode newNode(name, pos);
-                    newNode.next = next;
-                    secondaryIndex.push_back(std::move(newNode));
-                }
+    // Updates Primary Index on delete
+    // Deletes an entry and returns its old position, or -1. Secondary nodes point at
+    // record slots, so nothing else has to be renumbered.
+    int deletePrimary(string_view primaryKey) {
+        ensurePrimaryLoaded();
+        int deletedPos = (int)primaryIndex.erase(Entry{primaryKey, 0});
+        if (deletedPos != -1) {
+            searchSnapshot.invalidate();
+            if (!logSuppressed) {
+                primaryTree.erase(primaryKey);
+                primaryFilter.noteErase();
+                if (primaryFilter.needsRebuild()) rebuildFilter();
             }
+            logMutation(IndexLogOp::DeletePrimary, primaryKey, 0);
+            return deletedPos;
         }
+        return -1; // Not found
     }
 
-    void saveIndexes() {
-        // Save Primary Index
-        ofstream pOut(DOC_PRIMARY_INDEX_FILE, ios::binary | ios::trunc);
-        if (pOut.good()) {
-            size_t sz = primaryIndex.size();
-            pOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& p : primaryIndex) {
-                size_t len = p.doctorId.size();
-                pOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                pOut.write(p.doctorId.c_str(), len);
-                pOut.write(reinterpret_cast<const char*>(const_cast<short*>(&p.offset)), sizeof(p.offset));
-            }
+    // Bulk load: links a batch of new entries (sorted by primaryKey, none already
+    // present) under their secondary keys, then merges them into the primary index in one pass.
+    void bulkInsert(vector<Entry>& entries, const vector<string>& secondaryKeys) {
+        ensureLoaded();
+        prefixBuilt = false;
+        logSuppressed = true;
+        for (size_t k = 0; k < secondaryKeys.size(); k++) {
+            insertSecondary(secondaryKeys[k], entries[k].offset);
         }
-
-        // Save Secondary Index Heads and Nodes
-        ofstream sOut(DOC_SECONDARY_INDEX_FILE, ios::binary | ios::trunc);
-        if (sOut.good()) {
-            size_t sz = secondaryIndexHeads.size();
-            sOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& entry : secondaryIndexHeads) {
-                size_t len = entry.first.size();
-                sOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                sOut.write(entry.first.c_str(), len);
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&entry.second)), sizeof(entry.second));
-            }
-
-            sz = secondaryIndex.size();
-            sOut.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
-            for (const auto& node : secondaryIndex) {
-                size_t len = node.doctorName.size();
-                sOut.write(reinterpret_cast<const char*>(&len), sizeof(len));
-                sOut.write(node.doctorName.c_str(), len);
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&node.primaryIndexPos)), sizeof(node.primaryIndexPos));
-                sOut.write(reinterpret_cast<const char*>(const_cast<int*>(&node.next)), sizeof(node.next));
+        logSuppressed = false;
+
+        vector<Entry> merged;
+        merged.reserve(primaryIndex.size() + entries.size());
+        size_t j = 0;
+        auto it = primaryIndex.begin();
+        while (it != primaryIndex.end() || j < entries.size()) {
+            if (j == entries.size() || (it != primaryIndex.end() && *it < entries[j])) {
+                merged.push_back(*it++);
+            } else {
+                merged.push_back(std::move(entries[j++]));
             }
         }
-    }
+        primaryIndex.assign(std::move(merged));
 
+        // Bulk changes are not logged record by record; persist them in one checkpoint
+        rebuildTree();
+        rebuildFilter();
+        rebuildSnapshot();
+        saveIndexes();
+    }
 
-public:
-    DoctorIndexManager() { loadIndexes(); }
-    ~DoctorIndexManager() { saveIndexes(); }
-
-    // Binary Search Implementation
-    int binarySearchPrimary(const string& doctorId) const {
-        int left = 0;
-        int right = (int)primaryIndex.size() - 1;
-        while (left <= right) {
-            int mid = left + (right - left) / 2;
-            if (primaryIndex[mid].doctorId == doctorId) return mid;
-            else if (primaryIndex[mid].doctorId < doctorId) left = mid + 1;
-            else right = mid - 1;
+    // Replaces both indexes wholesale (used by compaction). entries must be sorted by
+    // primaryKey and secondaryKeys[i] is the secondary key of entries[i]. The secondary
+    // index is rebuilt contiguously, which drops nodes left unlinked by deletes.
+    void rebuild(vector<Entry>& entries, const vector<string>& secondaryKeys) {
+        ensureLoaded();
+        prefixBuilt = false;
+        secondaryIndex.clear();
+        secondaryIndex.reserve(secondaryKeys.size());
+        logSuppressed = true;
+        for (size_t i = 0; i < secondaryKeys.size(); i++) {
+            insertSecondary(secondaryKeys[i], entries[i].offset);
         }
-        return -1;
+        logSuppressed = false;
+        primaryIndex.assign(std::move(entries));
+        rebuildTree();
+        rebuildFilter();
+        rebuildSnapshot();
+        saveIndexes();
     }
 
-    // Keeps Primary Index Sorted & Task 4: The Binding
-    int insertPrimary(const string& doctorId, short offset) {
-        DocPrimaryIndexEntry newEntry{doctorId, offset};
-        auto it = std::lower_bound(primaryIndex.begin(), primaryIndex.end(), newEntry);
-        int pos = std::distance(primaryIndex.begin(), it);
-        primaryIndex.insert(it, newEntry);
-        return pos;
+    // Postings-list Secondary Index Management
+    // Appends the record slot to the key's list.
+    void insertSecondary(string_view secondaryKey, Offset offset) {
+        ensureSecondaryLoaded();
+        secondaryIndex.insert(secondaryKey, offset);
+        if (prefixBuilt) secondaryPrefix.insert(secondaryKey, offset);
+        logMutation(IndexLogOp::InsertSecondary, secondaryKey, offset);
     }
 
-    // Updates Primary Index on delete
-    int deletePrimary(const string& doctorId) {
-        DocPrimaryIndexEntry tempEntry{doctorId, 0};
-        auto it = std::lower_bound(primaryIndex.begin(), primaryIndex.end(), tempEntry);
-
-        if (it != primaryIndex.end() && it->doctorId == doctorId) {
-            int deletedPos = std::distance(primaryIndex.begin(), it);
-            primaryIndex.erase(it);
-            updateSecondaryIndicesOnErase(deletedPos);
-            return deletedPos;
+    // Removes the record slot from the key's list; the freed block space is reclaimed
+    // once enough of it has piled up.
+    void deleteSecondary(string_view secondaryKey, Offset offset) {
+        ensureSecondaryLoaded();
+        if (secondaryIndex.erase(secondaryKey, offset)) {
+            if (prefixBuilt) secondaryPrefix.erase(secondaryKey, offset);
+            logMutation(IndexLogOp::DeleteSecondary, secondaryKey, offset);
         }
-        return -1;
     }
 
-    // Linked-List Secondary Index Management
-    void insertSecondary(const string& doctorName, int primaryIndexPos) {
-        DocSecondaryIndexNode newNode(doctorName, primaryIndexPos);
-        int newNodeIdx = (int)secondaryIndex.size();
-        secondaryIndex.push_back(newNode);
-
-        auto head_it = secondaryIndexHeads.find(doctorName);
-        if (head_it == secondaryIndexHeads.end()) {
-            secondaryIndexHeads[doctorName] = newNodeIdx;
+    // --- Access/Search Methods ---
+    // Retrieves a single primary index entry by primary key
+    const Entry* searchByPrimary(string_view primaryKey) {
+        // A definite miss in the filter skips the search
+        ensureFilterLoaded();
+        if (!primaryFilter.mayContain(primaryKey)) return nullptr;
+        const Entry* hit = nullptr;
+        if (!primaryLoaded && !treeStale) {
+            int64_t offset;
+            if (primaryTree.find(primaryKey, offset)) {
+                treeHit = {primaryKey, (Offset)offset};
+                hit = &treeHit;
+            }
         } else {
-            // Prepend: New node points to old head
-            secondaryIndex[newNodeIdx].next = head_it->second;
-            // New node becomes the new head
-            head_it->second = newNodeIdx;
+            ensurePrimaryLoaded();
+            Entry probe{primaryKey, 0};
+            if (!searchSnapshot.current() && searchSnapshot.due(primaryIndex.size())) rebuildSnapshot();
+            if (searchSnapshot.current()) {
+                hit = searchSnapshot.find(Traits::key(probe));
+            } else {
+                long pos = primaryIndex.find(probe);
+                if (pos != -1) hit = &primaryIndex[pos];
+            }
         }
+        if (!hit) primaryFilter.countFalsePositive();
+        return hit;
     }
 
-    // Linked-List Secondary Index Deletion
-    void deleteSecondary(const string& doctorName, int primaryIndexPos) {
-        auto head_it = secondaryIndexHeads.find(doctorName);
-        if (head_it == secondaryIndexHeads.end()) return;
+    void printFilterStats(const string& label) {
+        ensureFilterLoaded();
+        primaryFilter.printStats(label);
+    }
 
-        int currentIdx = head_it->second;
-        int prevIdx = -1;
+    const PrimaryIndexStore<Entry>& primaryEntries() {
+        ensurePrimaryLoaded();
+        return primaryIndex;
+    }
+    size_t secondaryRefCount() {
+        ensureSecondaryLoaded();
+        return secondaryIndex.size();
+    }
 
-        while (currentIdx != -1) {
-            if (secondaryIndex[currentIdx].primaryIndexPos == primaryIndexPos) {
-                if (prevIdx == -1) {
-                    head_it->second = secondaryIndex[currentIdx].next;
-                    if (head_it->second == -1) secondaryIndexHeads.erase(head_it);
-                } else {
-                    secondaryIndex[prevIdx].next = secondaryIndex[currentIdx].next;
-                }
-                break;
-            }
-            prevIdx = currentIdx;
-            currentIdx = secondaryIndex[currentIdx].next;
-        }
+    // Retrieves the record slots of every entry with the given secondary key
+    vector<long> searchBySecondary(string_view secondaryKey) {
+        vector<long> results;
+        searchBySecondary(secondaryKey, results);
+        return results;
     }
 
-    // --- Access/Search Methods ---
-    const DocPrimaryIndexEntry* searchByPrimary(const string& doctorId) const {
-        int pos = binarySearchPrimary(doctorId);
-        if (pos != -1) return &primaryIndex[pos];
-        return nullptr;
-    }
-
-    vector<const DocPrimaryIndexEntry*> searchBySecondary(const string& doctorName) const {
-        vector<const DocPrimaryIndexEntry*> results;
-        auto head_it = secondaryIndexHeads.find(doctorName);
-        if (head_it == secondaryIndexHeads.end()) return results;
-
-        int currentIdx = head_it->second;
-        while (currentIdx != -1) {
-            int primaryPos = secondaryIndex[currentIdx].primaryIndexPos;
-            results.push_back(&primaryIndex[primaryPos]);
-            currentIdx = secondaryIndex[currentIdx].next;
-        }
+    // Same, into results (cleared first), so repeated searches reuse its capacity
+    void searchBySecondary(string_view secondaryKey, vector<long>& results) {
+        ensureSecondaryLoaded();
+        results.clear();
+        secondaryIndex.forEach(secondaryKey, [&results](Offset slot) { results.push_back(slot); });
+    }
+
+    // Record slots of every entry whose secondary key starts with prefix, ignoring case,
+    // in case-folded key order
+    vector<long> searchBySecondaryPrefix(string_view prefix) {
+        ensurePrefixIndex();
+        vector<long> results;
+        secondaryPrefix.forEachPrefix(prefix, [&results](Offset slot) { results.push_back(slot); });
+        return results;
+    }
+
+    // Record slots of every entry whose secondary key equals secondaryKey ignoring case
+    vector<long> searchBySecondaryFolded(string_view secondaryKey) {
+        ensurePrefixIndex();
+        vector<long> results;
+        secondaryPrefix.forEachFolded(secondaryKey, [&results](Offset slot) { results.push_back(slot); });
         return results;
     }
 };
 
+// Appointments: appointmentId -> slot, doctorId -> slots
+typedef IndexManager<AppointmentIndexTraits> AppointmentIndexManager;
+// Doctors: doctorId -> slot, doctorName -> slots
+typedef IndexManager<DoctorIndexTraits> DoctorIndexManager;
+
+// Appointments by (date, time): day and date range schedules
+struct AppointmentDateIndexTraits {
+    typedef CompositeKey<2> Key;
+    static const string& baseFile() { return APPT_DATE_INDEX_FILE; }
+    static const string& logFile() { return APPT_DATE_INDEX_LOG_FILE; }
+};
+typedef RangeIndexManager<AppointmentDateIndexTraits> AppointmentDateIndexManager;
+
+// Appointments by (patientId, date, time): a patient's history, already in date order
+struct AppointmentPatientIndexTraits {
+    typedef CompositeKey<3> Key;
+    static const string& baseFile() { return APPT_PATIENT_INDEX_FILE; }
+    static const string& logFile() { return APPT_PATIENT_INDEX_LOG_FILE; }
+};
+typedef RangeIndexManager<AppointmentPatientIndexTraits> AppointmentPatientIndexManager;
+
+// Appointments by (doctorId, date, time): one doctor's schedule for a day
+struct AppointmentDoctorDayIndexTraits {
+    typedef CompositeKey<3> Key;
+    static const string& baseFile() { return APPT_DOCTOR_DAY_INDEX_FILE; }
+    static const string& logFile() { return APPT_DOCTOR_DAY_INDEX_LOG_FILE; }
+};
+typedef RangeIndexManager<AppointmentDoctorDayIndexTraits> AppointmentDoctorDayIndexManager;
+
 #endif
\ No newline at end of file
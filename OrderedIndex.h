@@ -0,0 +1,536 @@
+#ifndef ORDERED_INDEX_H
+#define ORDERED_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+// IN-MEMORY PRIMARY INDEX STORES
+// Both keep entries sorted by Entry::operator< and address them by rank (position in
+// key order). They share one interface so the index managers can use either (see
+// PrimaryIndexStore in IndexManagers.h).
+//   SortedVector: the original layout. Binary search over one array, but insert and
+//                 erase shift every later entry, O(n) string moves per write.
+//   OrderedIndex: B+ tree with wide, cache-line aligned nodes of ORDERED_INDEX_FANOUT
+//                 entries / children. Inner nodes keep per-child entry counts, so
+//                 insert, erase, find and rank -> entry are all O(log n). A node that
+//                 drops below half full borrows from or merges with a sibling, so the
+//                 height stays logarithmic however the index shrinks.
+
+template <class Entry>
+class SortedVector {
+private:
+    vector<Entry> items;
+
+public:
+    typedef typename vector<Entry>::const_iterator const_iterator;
+
+    size_t size() const { return items.size(); }
+    const Entry& operator[](size_t rank) const { return items[rank]; }
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+
+    // Rank of the entry equal to probe, or -1.
+    long find(const Entry& probe) const {
+        auto it = lower_bound(items.begin(), items.end(), probe);
+        if (it == items.end() || probe < *it) return -1;
+        return (long)(it - items.begin());
+    }
+
+    // First entry not ordered before probe.
+    const_iterator lowerBound(const Entry& probe) const {
+        return lower_bound(items.begin(), items.end(), probe);
+    }
+
+    // Inserts e (not already present) and returns its rank.
+    size_t insert(const Entry& e) {
+        auto it = lower_bound(items.begin(), items.end(), e);
+        size_t rank = (size_t)(it - items.begin());
+        items.insert(it, e);
+        return rank;
+    }
+
+    // Removes the entry equal to probe and returns its old rank, or -1.
+    long erase(const Entry& probe) {
+        long rank = find(probe);
+        if (rank != -1) items.erase(items.begin() + rank);
+        return rank;
+    }
+
+    // Replaces the contents with entries already sorted by key.
+    void assign(vector<Entry>&& sorted) { items = std::move(sorted); }
+    // Same, with the n entries produced in key order by entryAt(0 .. n - 1).
+    template <class EntryAt>
+    void assign(size_t n, EntryAt entryAt) {
+        items.clear();
+        items.reserve(n);
+        for (size_t i = 0; i < n; i++) items.push_back(entryAt(i));
+    }
+    void clear() { items.clear(); }
+};
+
+const int ORDERED_INDEX_FANOUT = 32;
+
+template <class Entry>
+class OrderedIndex {
+private:
+    static const int CAP = ORDERED_INDEX_FANOUT;
+    static const int BULK_FILL = CAP - CAP / 4; // assign() leaves room for later inserts
+    static const int MIN_FILL = CAP / 2;        // Erase rebalances nodes below this
+
+    struct Node {
+        bool leaf;
+        int count; // Entries (leaf) or children (inner)
+    };
+    struct alignas(64) Leaf : Node {
+        Leaf* prev;
+        Leaf* next;
+        Entry items[CAP];
+    };
+    struct alignas(64) Inner : Node {
+        size_t sizes[CAP];   // Entries under each child
+        Node* children[CAP];
+        Entry lows[CAP];     // lows[i] <= every entry under children[i]; lows[0] is unused
+    };
+
+    Node* root;
+    Leaf* head; // First leaf, for in-order iteration
+    size_t total;
+
+    static Leaf* newLeaf() {
+        Leaf* lf = new Leaf();
+        lf->leaf = true;
+        lf->count = 0;
+        lf->prev = lf->next = nullptr;
+        return lf;
+    }
+    static Inner* newInner() {
+        Inner* in = new Inner();
+        in->leaf = false;
+        in->count = 0;
+        return in;
+    }
+
+    static void destroy(Node* n) {
+        if (!n) return;
+        if (n->leaf) {
+            delete static_cast<Leaf*>(n);
+            return;
+        }
+        Inner* in = static_cast<Inner*>(n);
+        for (int i = 0; i < in->count; i++) destroy(in->children[i]);
+        delete in;
+    }
+
+    static size_t subtreeSize(const Node* n) {
+        if (n->leaf) return (size_t)n->count;
+        const Inner* in = static_cast<const Inner*>(n);
+        size_t sum = 0;
+        for (int i = 0; i < in->count; i++) sum += in->sizes[i];
+        return sum;
+    }
+
+    static const Entry& firstOf(const Node* n) {
+        while (!n->leaf) n = static_cast<const Inner*>(n)->children[0];
+        return static_cast<const Leaf*>(n)->items[0];
+    }
+
+    // Child of in whose range holds e.
+    static int childFor(const Inner* in, const Entry& e) {
+        int lo = 1, hi = in->count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (e < in->lows[mid]) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo - 1;
+    }
+
+    static void leafInsertAt(Leaf* lf, int pos, const Entry& e) {
+        move_backward(lf->items + pos, lf->items + lf->count, lf->items + lf->count + 1);
+        lf->items[pos] = e;
+        lf->count++;
+    }
+
+    static void innerInsertAt(Inner* in, int pos, Node* child, size_t size, const Entry& low) {
+        for (int i = in->count; i > pos; i--) {
+            in->children[i] = in->children[i - 1];
+            in->sizes[i] = in->sizes[i - 1];
+            in->lows[i] = std::move(in->lows[i - 1]);
+        }
+        in->children[pos] = child;
+        in->sizes[pos] = size;
+        in->lows[pos] = low;
+        in->count++;
+    }
+
+    // Inserts e under n, adding the entries before it to rank. Returns the new right
+    // sibling if n had to split.
+    Node* insertInto(Node* n, const Entry& e, size_t& rank) {
+        if (n->leaf) {
+            Leaf* lf = static_cast<Leaf*>(n);
+            int pos = (int)(lower_bound(lf->items, lf->items + lf->count, e) - lf->items);
+            rank += (size_t)pos;
+            if (lf->count < CAP) {
+                leafInsertAt(lf, pos, e);
+                return nullptr;
+            }
+
+            Leaf* right = newLeaf();
+            int half = CAP / 2;
+            move(lf->items + half, lf->items + CAP, right->items);
+            right->count = CAP - half;
+            lf->count = half;
+            right->next = lf->next;
+            right->prev = lf;
+            if (lf->next) lf->next->prev = right;
+            lf->next = right;
+            if (pos <= half) leafInsertAt(lf, pos, e);
+            else leafInsertAt(right, pos - half, e);
+            return right;
+        }
+
+        Inner* in = static_cast<Inner*>(n);
+        int c = childFor(in, e);
+        for (int i = 0; i < c; i++) rank += in->sizes[i];
+        Node* sibling = insertInto(in->children[c], e, rank);
+        if (!sibling) {
+            in->sizes[c]++;
+            return nullptr;
+        }
+
+        size_t siblingSize = subtreeSize(sibling);
+        in->sizes[c] = in->sizes[c] + 1 - siblingSize;
+        const Entry& low = firstOf(sibling);
+        if (in->count < CAP) {
+            innerInsertAt(in, c + 1, sibling, siblingSize, low);
+            return nullptr;
+        }
+
+        Inner* right = newInner();
+        int half = CAP / 2;
+        for (int i = half; i < CAP; i++) {
+            right->children[i - half] = in->children[i];
+            right->sizes[i - half] = in->sizes[i];
+            right->lows[i - half] = std::move(in->lows[i]);
+        }
+        right->count = CAP - half;
+        in->count = half;
+        if (c + 1 <= half) innerInsertAt(in, c + 1, sibling, siblingSize, low);
+        else innerInsertAt(right, c + 1 - half, sibling, siblingSize, low);
+        return right;
+    }
+
+    // Removes the entry equal to probe under n, adding the entries before it to rank.
+    // Children left under half full are rebalanced; the caller handles n itself.
+    bool eraseFrom(Node* n, const Entry& probe, size_t& rank) {
+        if (n->leaf) {
+            Leaf* lf = static_cast<Leaf*>(n);
+            int pos = (int)(lower_bound(lf->items, lf->items + lf->count, probe) - lf->items);
+            if (pos == lf->count || probe < lf->items[pos]) return false;
+            move(lf->items + pos + 1, lf->items + lf->count, lf->items + pos);
+            lf->count--;
+            rank += (size_t)pos;
+            return true;
+        }
+
+        Inner* in = static_cast<Inner*>(n);
+        int c = childFor(in, probe);
+        for (int i = 0; i < c; i++) rank += in->sizes[i];
+        Node* child = in->children[c];
+        if (!eraseFrom(child, probe, rank)) return false;
+        in->sizes[c]--;
+        if (child->count < MIN_FILL && in->count > 1) rebalance(in, c);
+        return true;
+    }
+
+    // Refills in->children[c] from a neighbour: the two merge if they fit in one node
+    // below capacity, otherwise the child borrows the neighbour's nearest entry/child.
+    void rebalance(Inner* in, int c) {
+        int l = c > 0 ? c - 1 : c; // The pair is (l, l + 1)
+        Node* left = in->children[l];
+        Node* right = in->children[l + 1];
+
+        if (left->count + right->count < CAP) {
+            if (left->leaf) {
+                Leaf* a = static_cast<Leaf*>(left);
+                Leaf* b = static_cast<Leaf*>(right);
+                move(b->items, b->items + b->count, a->items + a->count);
+            } else {
+                Inner* a = static_cast<Inner*>(left);
+                Inner* b = static_cast<Inner*>(right);
+                for (int i = 0; i < b->count; i++) {
+                    a->children[a->count + i] = b->children[i];
+                    a->sizes[a->count + i] = b->sizes[i];
+                    a->lows[a->count + i] = std::move(i ? b->lows[i] : in->lows[l + 1]);
+                }
+            }
+            left->count += right->count;
+            right->count = 0;
+            freeEmpty(right);
+            in->sizes[l] += in->sizes[l + 1];
+            for (int i = l + 1; i + 1 < in->count; i++) {
+                in->children[i] = in->children[i + 1];
+                in->sizes[i] = in->sizes[i + 1];
+                in->lows[i] = std::move(in->lows[i + 1]);
+            }
+            in->count--;
+            return;
+        }
+
+        size_t moved; // Entries that changed sides
+        if (c > l) {
+            // Take the left neighbour's last entry/child
+            if (left->leaf) {
+                Leaf* a = static_cast<Leaf*>(left);
+                Leaf* b = static_cast<Leaf*>(right);
+                leafInsertAt(b, 0, a->items[a->count - 1]);
+                moved = 1;
+                in->lows[c] = b->items[0];
+            } else {
+                Inner* a = static_cast<Inner*>(left);
+                Inner* b = static_cast<Inner*>(right);
+                int last = a->count - 1;
+                moved = a->sizes[last];
+                innerInsertAt(b, 0, a->children[last], moved, Entry());
+                b->lows[1] = in->lows[c];
+                in->lows[c] = std::move(a->lows[last]);
+            }
+            left->count--;
+            in->sizes[l] -= moved;
+            in->sizes[l + 1] += moved;
+        } else {
+            // Take the right neighbour's first entry/child
+            if (left->leaf) {
+                Leaf* a = static_cast<Leaf*>(left);
+                Leaf* b = static_cast<Leaf*>(right);
+                a->items[a->count++] = std::move(b->items[0]);
+                move(b->items + 1, b->items + b->count, b->items);
+                b->count--;
+                moved = 1;
+                in->lows[l + 1] = b->items[0];
+            } else {
+                Inner* a = static_cast<Inner*>(left);
+                Inner* b = static_cast<Inner*>(right);
+                moved = b->sizes[0];
+                innerInsertAt(a, a->count, b->children[0], moved, in->lows[l + 1]);
+                in->lows[l + 1] = std::move(b->lows[1]);
+                for (int i = 0; i + 1 < b->count; i++) {
+                    b->children[i] = b->children[i + 1];
+                    b->sizes[i] = b->sizes[i + 1];
+                    b->lows[i] = std::move(b->lows[i + 1]);
+                }
+                b->count--;
+            }
+            in->sizes[l] += moved;
+            in->sizes[l + 1] -= moved;
+        }
+    }
+
+    void freeEmpty(Node* n) {
+        if (!n->leaf) {
+            delete static_cast<Inner*>(n);
+            return;
+        }
+        Leaf* lf = static_cast<Leaf*>(n);
+        if (lf->prev) lf->prev->next = lf->next;
+        else head = lf->next;
+        if (lf->next) lf->next->prev = lf->prev;
+        delete lf;
+    }
+
+public:
+    class const_iterator {
+    private:
+        const Leaf* lf;
+        int i;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Entry value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Entry* pointer;
+        typedef const Entry& reference;
+
+        const_iterator(const Leaf* leaf = nullptr, int index = 0) : lf(leaf), i(index) {}
+        reference operator*() const { return lf->items[i]; }
+        pointer operator->() const { return &lf->items[i]; }
+        const_iterator& operator++() {
+            if (++i == lf->count) {
+                lf = lf->next;
+                i = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const const_iterator& o) const { return lf == o.lf && i == o.i; }
+        bool operator!=(const const_iterator& o) const { return !(*this == o); }
+    };
+
+    OrderedIndex() : root(nullptr), head(nullptr), total(0) {}
+    ~OrderedIndex() { destroy(root); }
+
+    // Copies are rebuilt packed (used for checkpoint snapshots).
+    OrderedIndex(const OrderedIndex& other) : root(nullptr), head(nullptr), total(0) {
+        assign(vector<Entry>(other.begin(), other.end()));
+    }
+    OrderedIndex(OrderedIndex&& other) noexcept : root(other.root), head(other.head), total(other.total) {
+        other.root = nullptr;
+        other.head = nullptr;
+        other.total = 0;
+    }
+    OrderedIndex& operator=(OrderedIndex other) {
+        swap(root, other.root);
+        swap(head, other.head);
+        swap(total, other.total);
+        return *this;
+    }
+
+    size_t size() const { return total; }
+    const_iterator begin() const { return const_iterator(head, 0); }
+    const_iterator end() const { return const_iterator(); }
+
+    const Entry& operator[](size_t rank) const {
+        const Node* n = root;
+        while (!n->leaf) {
+            const Inner* in = static_cast<const Inner*>(n);
+            int c = 0;
+            while (rank >= in->sizes[c]) rank -= in->sizes[c++];
+            n = in->children[c];
+        }
+        return static_cast<const Leaf*>(n)->items[rank];
+    }
+
+    long find(const Entry& probe) const {
+        if (!root) return -1;
+        size_t rank = 0;
+        const Node* n = root;
+        while (!n->leaf) {
+            const Inner* in = static_cast<const Inner*>(n);
+            int c = childFor(in, probe);
+            for (int i = 0; i < c; i++) rank += in->sizes[i];
+            n = in->children[c];
+        }
+        const Leaf* lf = static_cast<const Leaf*>(n);
+        int pos = (int)(lower_bound(lf->items, lf->items + lf->count, probe) - lf->items);
+        if (pos == lf->count || probe < lf->items[pos]) return -1;
+        return (long)(rank + (size_t)pos);
+    }
+
+    // First entry not ordered before probe, for range scans.
+    const_iterator lowerBound(const Entry& probe) const {
+        if (!root) return end();
+        const Node* n = root;
+        while (!n->leaf) {
+            const Inner* in = static_cast<const Inner*>(n);
+            n = in->children[childFor(in, probe)];
+        }
+        const Leaf* lf = static_cast<const Leaf*>(n);
+        int pos = (int)(lower_bound(lf->items, lf->items + lf->count, probe) - lf->items);
+        // Everything in this leaf is smaller: the bound is the first entry of the next one
+        if (pos == lf->count) return const_iterator(lf->next, 0);
+        return const_iterator(lf, pos);
+    }
+
+    size_t insert(const Entry& e) {
+        if (!root) root = head = newLeaf();
+        size_t rank = 0;
+        Node* sibling = insertInto(root, e, rank);
+        if (sibling) {
+            Inner* up = newInner();
+            up->children[0] = root;
+            up->sizes[0] = subtreeSize(root);
+            up->count = 1;
+            innerInsertAt(up, 1, sibling, subtreeSize(sibling), firstOf(sibling));
+            root = up;
+        }
+        total++;
+        return rank;
+    }
+
+    long erase(const Entry& probe) {
+        size_t rank = 0;
+        if (!root || !eraseFrom(root, probe, rank)) return -1;
+        total--;
+        if (root->count == 0) {
+            freeEmpty(root);
+            root = nullptr;
+            head = nullptr;
+        }
+        while (root && !root->leaf && root->count == 1) {
+            Inner* old = static_cast<Inner*>(root);
+            root = old->children[0];
+            delete old;
+        }
+        return (long)rank;
+    }
+
+    // Builds the tree bottom-up from entries already sorted by key.
+    void assign(vector<Entry>&& sorted) {
+        assign(sorted.size(), [&sorted](size_t i) { return std::move(sorted[i]); });
+    }
+
+    // Same, with the entries produced in key order by entryAt(0 .. count - 1), e.g.
+    // straight from a mapped index file.
+    template <class EntryAt>
+    void assign(size_t count, EntryAt entryAt) {
+        clear();
+        if (count == 0) return;
+        total = count;
+
+        vector<Node*> level;
+        vector<size_t> sizes;
+        Leaf* prev = nullptr;
+        for (size_t i = 0; i < count; i += BULK_FILL) {
+            Leaf* lf = newLeaf();
+            size_t n = min(count - i, (size_t)BULK_FILL);
+            for (size_t k = 0; k < n; k++) lf->items[k] = entryAt(i + k);
+            lf->count = (int)n;
+            lf->prev = prev;
+            if (prev) prev->next = lf;
+            else head = lf;
+            prev = lf;
+            level.push_back(lf);
+            sizes.push_back(n);
+        }
+
+        while (level.size() > 1) {
+            vector<Node*> upper;
+            vector<size_t> upperSizes;
+            for (size_t i = 0; i < level.size(); i += BULK_FILL) {
+                Inner* in = newInner();
+                size_t n = min(level.size() - i, (size_t)BULK_FILL);
+                size_t sum = 0;
+                for (size_t k = 0; k < n; k++) {
+                    in->children[k] = level[i + k];
+                    in->sizes[k] = sizes[i + k];
+                    if (k) in->lows[k] = firstOf(level[i + k]);
+                    sum += sizes[i + k];
+                }
+                in->count = (int)n;
+                upper.push_back(in);
+                upperSizes.push_back(sum);
+            }
+            level.swap(upper);
+            sizes.swap(upperSizes);
+        }
+        root = level[0];
+    }
+
+    void clear() {
+        destroy(root);
+        root = nullptr;
+        head = nullptr;
+        total = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef POSTINGS_INDEX_H
+#define POSTINGS_INDEX_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <istream>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+// IN-MEMORY SECONDARY INDEX (postings lists)
+// Maps a secondary key to the record slots that carry it. All lists share one slots
+// array (CSR layout): a key owns the run [begin, begin + count) of it, so reading a
+// list is a scan of contiguous Slots with no per-record key copy or next link. Inserts
+// go to a small per-key tail; once the tail reaches 1/POSTINGS_TAIL_RATIO of the block
+// (and at least POSTINGS_TAIL_MIN), block and tail are moved together to the end of the
+// array. Runs left behind are reclaimed once they outweigh the live slots.
+// Lists are kept oldest first and read newest first, the order the old linked nodes gave.
+
+const size_t POSTINGS_TAIL_MIN = 16;
+const size_t POSTINGS_TAIL_RATIO = 8;
+
+// Lets the key map be searched with a string_view without building a string.
+struct StringViewHash {
+    using is_transparent = void;
+    size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+};
+
+template <class Slot>
+class PostingsIndex {
+private:
+    struct List {
+        size_t begin = 0;  // First slot of the block in slots
+        size_t count = 0;  // Slots in the block
+        vector<Slot> tail; // Inserted since the block was last laid out
+    };
+
+    vector<Slot> slots;
+    unordered_map<string, List, StringViewHash, equal_to<>> lists;
+    size_t live = 0; // Slots referenced from some list (block or tail)
+    size_t dead = 0; // Slots of the array no block covers any more
+
+    // Moves a list's block and tail to the end of the array as one block.
+    void relocate(List& list) {
+        size_t begin = slots.size();
+        // The block is copied from the array itself, so make room first
+        size_t needed = slots.size() + list.count + list.tail.size();
+        if (needed > slots.capacity()) slots.reserve(max(needed, 2 * slots.capacity()));
+        slots.insert(slots.end(), slots.begin() + list.begin, slots.begin() + list.begin + list.count);
+        slots.insert(slots.end(), list.tail.begin(), list.tail.end());
+        dead += list.count;
+        list.begin = begin;
+        list.count += list.tail.size();
+        list.tail.clear();
+        list.tail.shrink_to_fit();
+    }
+
+    // Rebuilds the array with every list folded into one block, dropping dead runs.
+    void repack() {
+        vector<Slot> packed;
+        packed.reserve(live);
+        for (auto& entry : lists) {
+            List& list = entry.second;
+            size_t begin = packed.size();
+            packed.insert(packed.end(), slots.begin() + list.begin, slots.begin() + list.begin + list.count);
+            packed.insert(packed.end(), list.tail.begin(), list.tail.end());
+            list.begin = begin;
+            list.count = packed.size() - begin;
+            list.tail.clear();
+            list.tail.shrink_to_fit();
+        }
+        slots.swap(packed);
+        dead = 0;
+    }
+
+public:
+    size_t size() const { return live; }
+    size_t keyCount() const { return lists.size(); }
+
+    void clear() {
+        slots.clear();
+        lists.clear();
+        live = dead = 0;
+    }
+    void reserve(size_t refs) { slots.reserve(refs); }
+
+    void insert(string_view key, Slot slot) {
+        auto it = lists.find(key);
+        if (it == lists.end()) it = lists.emplace(string(key), List()).first;
+        List& list = it->second;
+        if (list.count == 0 && list.tail.empty()) {
+            // New key: its block can start at the end of the array
+            list.begin = slots.size();
+        }
+        if (list.begin + list.count == slots.size() && list.tail.empty()) {
+            // Block is last in the array; grow it in place
+            slots.push_back(slot);
+            list.count++;
+        } else {
+            list.tail.push_back(slot);
+            if (list.tail.size() >= max(POSTINGS_TAIL_MIN, list.count / POSTINGS_TAIL_RATIO)) relocate(list);
+        }
+        live++;
+        if (dead > POSTINGS_TAIL_MIN && dead > live) repack();
+    }
+
+    // Removes one reference to slot under key. Returns false if there was none.
+    bool erase(string_view key, Slot slot) {
+        auto it = lists.find(key);
+        if (it == lists.end()) return false;
+        List& list = it->second;
+
+        auto tailIt = find(list.tail.begin(), list.tail.end(), slot);
+        if (tailIt != list.tail.end()) {
+            list.tail.erase(tailIt);
+        } else {
+            auto first = slots.begin() + list.begin;
+            auto last = first + list.count;
+            auto blockIt = find(first, last, slot);
+            if (blockIt == last) return false;
+            copy(blockIt + 1, last, blockIt);
+            list.count--;
+            dead++;
+        }
+        live--;
+        if (list.count == 0 && list.tail.empty()) lists.erase(it);
+        if (dead > POSTINGS_TAIL_MIN && dead > live) repack();
+        return true;
+    }
+
+    // Calls f(slot) for every reference under key, newest first.
+    template <class F>
+    void forEach(string_view key, F f) const {
+        auto it = lists.find(key);
+        if (it == lists.end()) return;
+        const List& list = it->second;
+        for (auto t = list.tail.rbegin(); t != list.tail.rend(); ++t) f(*t);
+        for (size_t i = list.count; i-- > 0;) f(slots[list.begin + i]);
+    }
+
+    // Calls f(key, slot) for every reference, key by key in no particular order.
+    template <class F>
+    void forEachEntry(F f) const {
+        for (const auto& entry : lists) {
+            const List& list = entry.second;
+            for (size_t i = 0; i < list.count; i++) f(string_view(entry.first), slots[list.begin + i]);
+            for (Slot s : list.tail) f(string_view(entry.first), s);
+        }
+    }
+
+    // V2 body (see IndexFile.h): per key a uint64 length, the bytes, a uint64 slot count
+    // and the slots as int64, oldest first. out needs write(data, len) and writeU64(v).
+    // Each list is written as one block and loads back contiguous.
+    template <class Writer>
+    void write(Writer& out) const {
+        vector<int64_t> wide;
+        for (const auto& entry : lists) {
+            const List& list = entry.second;
+            out.writeU64(entry.first.size());
+            out.write(entry.first.data(), entry.first.size());
+            wide.assign(slots.begin() + list.begin, slots.begin() + list.begin + list.count);
+            wide.insert(wide.end(), list.tail.begin(), list.tail.end());
+            out.writeU64(wide.size());
+            out.write(wide.data(), wide.size() * sizeof(int64_t));
+        }
+    }
+
+    // Reads the lists write() produced for keys keys, from memory (a mapped, verified file).
+    void read(const char* p, size_t bytes, size_t keys) {
+        clear();
+        const char* end = p + bytes;
+        auto readU64 = [&p, end](uint64_t& v) {
+            if ((size_t)(end - p) < sizeof(v)) return false;
+            memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            return true;
+        };
+        for (size_t i = 0; i < keys; i++) {
+            uint64_t len, count;
+            if (!readU64(len) || (uint64_t)(end - p) < len) break;
+            string_view key(p, (size_t)len);
+            p += len;
+            if (!readU64(count) || (uint64_t)(end - p) / sizeof(int64_t) < count) break;
+            size_t begin = slots.size();
+            slots.resize(begin + count);
+            if constexpr (sizeof(Slot) == sizeof(int64_t)) {
+                memcpy(slots.data() + begin, p, count * sizeof(int64_t));
+                p += count * sizeof(int64_t);
+            } else {
+                for (size_t k = 0; k < count; k++, p += sizeof(int64_t)) {
+                    int64_t slot;
+                    memcpy(&slot, p, sizeof(slot));
+                    slots[begin + k] = (Slot)slot;
+                }
+            }
+            if (count == 0) continue;
+            List& list = lists[string(key)];
+            list.begin = begin;
+            list.count = count;
+            live += count;
+        }
+    }
+};
+
+#endif //POSTINGS_INDEX_H
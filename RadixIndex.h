@@ -0,0 +1,176 @@
+#ifndef RADIX_INDEX_H
+#define RADIX_INDEX_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+// CASE-FOLDED PREFIX INDEX (radix tree)
+// Maps keys, folded to lower case (ASCII), to record slots. Each edge carries a run of
+// bytes, so a lookup costs one step per branching point rather than per character, and
+// children are kept ordered by their first byte so a depth-first walk enumerates keys
+// in folded byte order. Slots under one folded key are kept in ascending order.
+//   forEachPrefix("ahm")  every key starting with "ahm", "Ahm", "AHM", ...
+//   forEachFolded("ahmed ali")  keys equal to it ignoring case
+// Erasing merges a node left with one child back into it, so the tree stays compressed.
+
+template <class Slot>
+class RadixIndex {
+private:
+    struct Node {
+        string label;                    // Bytes on the edge from the parent (folded)
+        vector<unique_ptr<Node>> children; // Ordered by label[0]
+        vector<Slot> slots;              // Keys ending at this node
+    };
+
+    Node root;
+    size_t total = 0;
+
+    static string fold(string_view key) {
+        string folded(key);
+        for (char& c : folded) c = (char)tolower((unsigned char)c);
+        return folded;
+    }
+
+    static size_t commonPrefix(const string& a, string_view b) {
+        size_t n = min(a.size(), b.size()), i = 0;
+        while (i < n && a[i] == b[i]) i++;
+        return i;
+    }
+
+    // Position of the child whose label starts with c, or where it would go.
+    static typename vector<unique_ptr<Node>>::iterator childPos(Node* n, char c) {
+        return lower_bound(n->children.begin(), n->children.end(), (unsigned char)c,
+                           [](const unique_ptr<Node>& child, unsigned char b) {
+                               return (unsigned char)child->label[0] < b;
+                           });
+    }
+    static Node* childFor(Node* n, char c) {
+        auto it = childPos(n, c);
+        return (it != n->children.end() && (*it)->label[0] == c) ? it->get() : nullptr;
+    }
+
+    // Node for the folded key exactly, or nullptr.
+    Node* findNode(string_view rest) {
+        Node* n = &root;
+        while (!rest.empty()) {
+            Node* child = childFor(n, rest[0]);
+            if (!child || commonPrefix(child->label, rest) != child->label.size()) return nullptr;
+            rest.remove_prefix(child->label.size());
+            n = child;
+        }
+        return n;
+    }
+
+    template <class F>
+    static void walk(const Node* n, F& f) {
+        for (Slot s : n->slots) f(s);
+        for (const auto& child : n->children) walk(child.get(), f);
+    }
+
+public:
+    size_t size() const { return total; }
+
+    void clear() {
+        root.children.clear();
+        root.slots.clear();
+        total = 0;
+    }
+
+    void insert(string_view key, Slot slot) {
+        string folded = fold(key);
+        string_view rest = folded;
+        Node* n = &root;
+        while (!rest.empty()) {
+            auto it = childPos(n, rest[0]);
+            if (it == n->children.end() || (*it)->label[0] != rest[0]) {
+                unique_ptr<Node> leaf(new Node());
+                leaf->label = string(rest);
+                n = n->children.insert(it, std::move(leaf))->get();
+                rest = string_view();
+                break;
+            }
+            Node* child = it->get();
+            size_t common = commonPrefix(child->label, rest);
+            if (common < child->label.size()) {
+                // Split the edge where the key leaves it
+                unique_ptr<Node> mid(new Node());
+                mid->label = child->label.substr(0, common);
+                child->label.erase(0, common);
+                mid->children.push_back(std::move(*it));
+                *it = std::move(mid);
+                child = it->get();
+            }
+            rest.remove_prefix(common);
+            n = child;
+        }
+        n->slots.insert(upper_bound(n->slots.begin(), n->slots.end(), slot), slot);
+        total++;
+    }
+
+    // Removes one (key, slot) pair. Returns false if it was not indexed.
+    bool erase(string_view key, Slot slot) {
+        string folded = fold(key);
+        string_view rest = folded;
+        vector<Node*> path{&root};
+        while (!rest.empty()) {
+            Node* child = childFor(path.back(), rest[0]);
+            if (!child || commonPrefix(child->label, rest) != child->label.size()) return false;
+            rest.remove_prefix(child->label.size());
+            path.push_back(child);
+        }
+        Node* n = path.back();
+        auto it = lower_bound(n->slots.begin(), n->slots.end(), slot);
+        if (it == n->slots.end() || *it != slot) return false;
+        n->slots.erase(it);
+        total--;
+
+        // Drop the node if it is now empty, then fold a single remaining child into its parent
+        if (path.size() > 1 && n->slots.empty() && n->children.empty()) {
+            Node* parent = path[path.size() - 2];
+            parent->children.erase(childPos(parent, n->label[0]));
+            path.pop_back();
+            n = parent;
+        }
+        if (path.size() > 1 && n->slots.empty() && n->children.size() == 1) {
+            unique_ptr<Node> only = std::move(n->children[0]);
+            n->label += only->label;
+            n->children = std::move(only->children);
+            n->slots = std::move(only->slots);
+        }
+        return true;
+    }
+
+    // Calls f(slot) for every key starting with prefix (ignoring case), in folded key order.
+    template <class F>
+    void forEachPrefix(string_view prefix, F f) {
+        string folded = fold(prefix);
+        string_view rest = folded;
+        Node* n = &root;
+        while (!rest.empty()) {
+            Node* child = childFor(n, rest[0]);
+            if (!child) return;
+            size_t common = commonPrefix(child->label, rest);
+            if (common < rest.size() && common < child->label.size()) return; // Diverged mid-edge
+            rest.remove_prefix(common);
+            n = child; // The prefix may end inside this edge; everything below still matches
+        }
+        walk(n, f);
+    }
+
+    // Calls f(slot) for every key equal to key ignoring case.
+    template <class F>
+    void forEachFolded(string_view key, F f) {
+        string folded = fold(key);
+        Node* n = findNode(folded);
+        if (!n) return;
+        for (Slot s : n->slots) f(s);
+    }
+};
+
+#endif //RADIX_INDEX_H
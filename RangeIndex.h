@@ -0,0 +1,197 @@
+#ifndef RANGE_INDEX_H
+#define RANGE_INDEX_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "IndexLog.h"
+#include "OrderedIndex.h"
+#include "FixedKey.h"
+#include "IndexFile.h"
+
+using namespace std;
+
+// ORDERED SECONDARY INDEX (range scans)
+// Keeps (key, record slot) pairs sorted by key, then slot, in an OrderedIndex, so every
+// record whose key falls in [from, to] is one descent plus a walk along the leaves.
+// Keys are CompositeKeys of fixed-width fields compared field by field: a scan over a
+// prefix of the fields bounds the remaining ones with FixedKey() and FixedKey::highest().
+//
+// Persistence follows IndexManager: a base file rewritten by checkpoints, and a log of
+// the inserts / deletes since (the key's raw bytes, value = slot). The base is a v2 index
+// file (IndexFile.h) holding the entries as stored. A base in another layout is ignored;
+// the owner sees the index come up short and rebuilds it from the records.
+
+const uint64_t RANGE_INDEX_MAGIC = 0x32304E4752584449; // "IDXRNG02"
+
+// N fixed-width fields ordered lexicographically, e.g. (date, time).
+template <size_t N>
+struct CompositeKey {
+    FixedKey parts[N];
+
+    bool operator<(const CompositeKey& other) const {
+        for (size_t i = 0; i < N; i++) {
+            int c = FixedKey::compare(parts[i], other.parts[i]);
+            if (c != 0) return c < 0;
+        }
+        return false;
+    }
+    bool operator==(const CompositeKey& other) const {
+        for (size_t i = 0; i < N; i++) {
+            if (parts[i] != other.parts[i]) return false;
+        }
+        return true;
+    }
+};
+
+template <class Key>
+struct RangeIndexEntry {
+    Key key;
+    int64_t offset; // Record slot
+
+    bool operator<(const RangeIndexEntry& other) const {
+        if (key < other.key) return true;
+        if (other.key < key) return false;
+        return offset < other.offset;
+    }
+};
+
+// Traits supply:
+//   Key        the CompositeKey type
+//   baseFile() / logFile()
+template <class Traits>
+class RangeIndexManager {
+public:
+    typedef typename Traits::Key Key;
+    typedef RangeIndexEntry<Key> Entry;
+
+private:
+    OrderedIndex<Entry> index;
+    IndexCheckpointer checkpointer;
+    bool logSuppressed; // Set while replaying the log
+    bool loaded;
+
+    static string_view keyBytes(const Key& key) {
+        return string_view(reinterpret_cast<const char*>(&key), sizeof(Key));
+    }
+
+    void loadIndex() {
+        MappedIndexFile file;
+        if (!file.open(Traits::baseFile()) || file.magic() != RANGE_INDEX_MAGIC ||
+            file.header().entryBytes != sizeof(Entry)) {
+            return;
+        }
+        file.verify(sizeof(Entry));
+        const Entry* first = reinterpret_cast<const Entry*>(file.body());
+        index.assign(vector<Entry>(first, first + file.header().count));
+    }
+
+    void replayLog() {
+        bool needsCheckpoint;
+        vector<IndexLogRecord> records = checkpointer.recover(needsCheckpoint);
+        logSuppressed = true;
+        for (const auto& rec : records) {
+            if (rec.key.size() != sizeof(Key)) continue;
+            Key key;
+            memcpy(&key, rec.key.data(), sizeof(Key));
+            if (rec.op == IndexLogOp::InsertSecondary) insert(key, rec.value);
+            else if (rec.op == IndexLogOp::DeleteSecondary) erase(key, rec.value);
+        }
+        logSuppressed = false;
+        if (needsCheckpoint) saveIndex();
+    }
+
+    void ensureLoaded() {
+        if (loaded) return;
+        loaded = true;
+        loadIndex();
+        replayLog();
+    }
+
+    // Writes "<base>.tmp" for the checkpointer to rename into place.
+    static bool writeBaseFile(const OrderedIndex<Entry>& entries, uint64_t generation) {
+        IndexFileWriter out(Traits::baseFile() + ".tmp", RANGE_INDEX_MAGIC, sizeof(Entry), generation);
+        for (const auto& e : entries) out.write(&e, sizeof(e));
+        return out.finish(entries.size(), entries.size());
+    }
+
+    void saveIndex() {
+        checkpointer.finish();
+        checkpointer.install([this](uint64_t generation) { return writeBaseFile(index, generation); });
+    }
+
+    void logMutation(IndexLogOp op, const Key& key, int64_t value) {
+        if (logSuppressed) return;
+        checkpointer.append(op, keyBytes(key), value);
+        if (checkpointer.due(index.size())) {
+            checkpointer.start([snapshot = index](uint64_t generation) { return writeBaseFile(snapshot, generation); });
+        }
+    }
+
+public:
+    // No secondary base: the checkpointer manages the one base file and the log.
+    RangeIndexManager() : checkpointer(Traits::baseFile(), "", Traits::logFile()), logSuppressed(false), loaded(false) {}
+    ~RangeIndexManager() {
+        checkpointer.finish();
+    }
+
+    size_t size() {
+        ensureLoaded();
+        return index.size();
+    }
+
+    void insert(const Key& key, int64_t slot) {
+        ensureLoaded();
+        index.insert(Entry{key, slot});
+        logMutation(IndexLogOp::InsertSecondary, key, slot);
+    }
+
+    // Removes the (key, slot) pair. Returns false if it was not indexed.
+    bool erase(const Key& key, int64_t slot) {
+        ensureLoaded();
+        if (index.erase(Entry{key, slot}) == -1) return false;
+        logMutation(IndexLogOp::DeleteSecondary, key, slot);
+        return true;
+    }
+
+    // Calls f(slot) for every entry with from <= key <= to, in key order.
+    template <class F>
+    void scan(const Key& from, const Key& to, F f) {
+        ensureLoaded();
+        for (auto it = index.lowerBound(Entry{from, INT64_MIN}); it != index.end() && !(to < it->key); ++it) {
+            f((long)it->offset);
+        }
+    }
+
+    vector<long> range(const Key& from, const Key& to) {
+        vector<long> results;
+        scan(from, to, [&results](long slot) { results.push_back(slot); });
+        return results;
+    }
+
+    // Adds a batch of entries (any order) in one merge and checkpoints.
+    void bulkInsert(vector<Entry>& entries) {
+        ensureLoaded();
+        sort(entries.begin(), entries.end());
+        vector<Entry> merged;
+        merged.reserve(index.size() + entries.size());
+        merge(index.begin(), index.end(), entries.begin(), entries.end(), back_inserter(merged));
+        index.assign(std::move(merged));
+        saveIndex();
+    }
+
+    // Replaces the whole index (compaction, or rebuilding a missing one) and checkpoints.
+    void rebuild(vector<Entry>& entries) {
+        ensureLoaded();
+        sort(entries.begin(), entries.end());
+        index.assign(std::move(entries));
+        saveIndex();
+    }
+};
+
+#endif //RANGE_INDEX_H
@@ -0,0 +1,637 @@
+#ifndef RECORD_FILE_H
+#define RECORD_FILE_H
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <iostream>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// --- Positioned I/O helpers ---
+// Thin wrappers so the rest of the code does not care which platform it runs on.
+
+inline int openDataFd(const string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+#endif
+}
+
+inline void closeDataFd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+inline bool truncateDataFd(int fd, int64_t bytes) {
+#ifdef _WIN32
+    return _chsize_s(fd, bytes) == 0;
+#else
+    return ftruncate(fd, (off_t)bytes) == 0;
+#endif
+}
+
+// Forces written data to stable storage.
+inline bool syncDataFd(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+// Makes a rename or a new file in the directory that holds path durable.
+inline bool syncParentDir(const string& path) {
+#ifdef _WIN32
+    return true; // No directory handle to flush; NTFS journals renames itself
+#else
+    string dir = filesystem::path(path).parent_path().string();
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+inline int64_t dataFdSize(int fd) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) return -1;
+#else
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+#endif
+    return (int64_t)st.st_size;
+}
+
+// Reads exactly len bytes at byteOffset. Returns the number of bytes read (short at EOF).
+inline size_t preadFully(int fd, void* buf, size_t len, int64_t byteOffset) {
+    char* p = static_cast<char*>(buf);
+    size_t done = 0;
+    while (done < len) {
+#ifdef _WIN32
+        if (_lseeki64(fd, byteOffset + done, SEEK_SET) < 0) break;
+        int n = _read(fd, p + done, (unsigned)(len - done));
+#else
+        ssize_t n = ::pread(fd, p + done, len - done, (off_t)(byteOffset + done));
+#endif
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    return done;
+}
+
+inline bool pwriteFully(int fd, const void* buf, size_t len, int64_t byteOffset) {
+    const char* p = static_cast<const char*>(buf);
+    size_t done = 0;
+    while (done < len) {
+#ifdef _WIN32
+        if (_lseeki64(fd, byteOffset + done, SEEK_SET) < 0) return false;
+        int n = _write(fd, p + done, (unsigned)(len - done));
+#else
+        ssize_t n = ::pwrite(fd, p + done, len - done, (off_t)(byteOffset + done));
+#endif
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// --- Crash points ---
+// Tests put the name of a point in ASS1_CRASH_AT to have the program die there, as if
+// killed, between two steps whose order matters to crash recovery.
+inline void crashPoint(const char* name) {
+    static const char* target = getenv("ASS1_CRASH_AT");
+    if (target && strcmp(target, name) == 0) _Exit(137);
+}
+
+// BUFFER POOL
+// Page-granular LRU cache shared by every RecordFile. A page holds a whole number of
+// records, so a record never straddles two frames. Record appends and overwrites are
+// written through and only update the cached copy, so a crash never loses a record the
+// indexes already point at. Frames can still be marked dirty and written back on
+// eviction or flush; the on-disk B+ tree uses that for its pages.
+
+const size_t BUFFER_POOL_PAGE_BYTES = 4096;
+const size_t DEFAULT_BUFFER_POOL_MB = 16;
+
+// Batch reads merge missing pages into one I/O when they are at most this many pages
+// apart, up to a run of BATCH_READ_MAX_RUN_PAGES pages.
+const long BATCH_READ_MAX_GAP_PAGES = 4;
+const long BATCH_READ_MAX_RUN_PAGES = 256;
+
+class BufferPool {
+private:
+    struct Frame {
+        int fd;
+        long pageNo;
+        int64_t byteOffset; // Where the page starts in its file
+        size_t validBytes;  // Bytes of the page that exist in the file
+        bool dirty;
+        vector<char> data;
+    };
+
+    list<Frame> frames; // Most recently used at the front
+    unordered_map<uint64_t, list<Frame>::iterator> table;
+    size_t capacityBytes;
+    size_t usedBytes;
+
+    size_t hitCount;
+    size_t missCount;
+    size_t evictionCount;
+    size_t writeBackCount;
+
+    static uint64_t key(int fd, long pageNo) {
+        return ((uint64_t)(uint32_t)fd << 40) | (uint64_t)pageNo;
+    }
+
+    void writeBack(Frame& f) {
+        if (!f.dirty) return;
+        if (!pwriteFully(f.fd, f.data.data(), f.validBytes, f.byteOffset)) {
+            throw runtime_error("Buffer pool failed to write back page " + to_string(f.pageNo));
+        }
+        f.dirty = false;
+        writeBackCount++;
+    }
+
+    void evictUntilFits(size_t incoming) {
+        while (!frames.empty() && usedBytes + incoming > capacityBytes) {
+            Frame& victim = frames.back();
+            writeBack(victim);
+            usedBytes -= victim.data.size();
+            table.erase(key(victim.fd, victim.pageNo));
+            frames.pop_back();
+            evictionCount++;
+        }
+    }
+
+public:
+    BufferPool()
+        : capacityBytes(DEFAULT_BUFFER_POOL_MB << 20), usedBytes(0),
+          hitCount(0), missCount(0), evictionCount(0), writeBackCount(0) {}
+
+    ~BufferPool() {
+        try { flushAll(); } catch (...) {}
+    }
+
+    void setCapacityMB(size_t mb) {
+        capacityBytes = mb << 20;
+        evictUntilFits(0);
+    }
+
+    // Returns the cached page, or nullptr on a miss.
+    char* find(int fd, long pageNo) {
+        auto it = table.find(key(fd, pageNo));
+        if (it == table.end()) {
+            missCount++;
+            return nullptr;
+        }
+        hitCount++;
+        frames.splice(frames.begin(), frames, it->second);
+        return it->second->data.data();
+    }
+
+    // Allocates a frame for a page that missed; the caller fills the returned buffer.
+    char* insert(int fd, long pageNo, size_t pageBytes, int64_t byteOffset, size_t validBytes) {
+        evictUntilFits(pageBytes);
+        frames.push_front(Frame{fd, pageNo, byteOffset, validBytes, false, vector<char>(pageBytes, 0)});
+        table[key(fd, pageNo)] = frames.begin();
+        usedBytes += pageBytes;
+        return frames.front().data.data();
+    }
+
+    // Looks a page up without touching the LRU order or the counters.
+    char* peek(int fd, long pageNo) {
+        auto it = table.find(key(fd, pageNo));
+        return it == table.end() ? nullptr : it->second->data.data();
+    }
+
+    // Forgets a page without writing it back (used when filling a new frame failed).
+    void discard(int fd, long pageNo) {
+        auto it = table.find(key(fd, pageNo));
+        if (it == table.end()) return;
+        usedBytes -= it->second->data.size();
+        frames.erase(it->second);
+        table.erase(it);
+    }
+
+    void markDirty(int fd, long pageNo) {
+        auto it = table.find(key(fd, pageNo));
+        if (it != table.end()) it->second->dirty = true;
+    }
+
+    void extendValid(int fd, long pageNo, size_t validBytes) {
+        auto it = table.find(key(fd, pageNo));
+        if (it != table.end() && validBytes > it->second->validBytes) it->second->validBytes = validBytes;
+    }
+
+    void flushFile(int fd) {
+        for (auto& f : frames) {
+            if (f.fd == fd) writeBack(f);
+        }
+    }
+
+    // Flushes and forgets every page that belongs to fd (used when a file is closed).
+    void dropFile(int fd) {
+        for (auto it = frames.begin(); it != frames.end();) {
+            if (it->fd == fd) {
+                writeBack(*it);
+                usedBytes -= it->data.size();
+                table.erase(key(it->fd, it->pageNo));
+                it = frames.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void flushAll() {
+        for (auto& f : frames) writeBack(f);
+    }
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    size_t evictions() const { return evictionCount; }
+    size_t writeBacks() const { return writeBackCount; }
+    size_t capacity() const { return capacityBytes; }
+    size_t used() const { return usedBytes; }
+    size_t dirtyPages() const {
+        size_t n = 0;
+        for (const auto& f : frames) n += f.dirty ? 1 : 0;
+        return n;
+    }
+
+    void printStats() const {
+        size_t lookups = hitCount + missCount;
+        cout << "Buffer pool: " << (usedBytes >> 10) << " KB used of " << (capacityBytes >> 20) << " MB"
+             << " | Pages: " << frames.size() << " (" << dirtyPages() << " dirty)"
+             << " | Hits: " << hitCount << " | Misses: " << missCount
+             << " | Hit rate: " << (lookups ? (100.0 * hitCount / lookups) : 0.0) << "%"
+             << " | Evictions: " << evictionCount << " | Write-backs: " << writeBackCount << "\n";
+    }
+};
+
+// Shared by the appointment and doctor data files
+inline BufferPool recordBufferPool;
+
+// RECORD FILE
+// One long-lived descriptor per fixed-width data file. Records are addressed by
+// slot number (record N lives at N * recordSize), so every access is a single
+// positioned read or write instead of an open/seek/close round trip.
+// Record I/O goes through recordBufferPool. On POSIX systems pool misses are filled
+// from a shared read-only mapping of the file; writes use pwrite, which lands in the
+// same page cache the mapping sees.
+
+class RecordFile {
+private:
+    string path;
+    size_t recordSize;
+    int fd;
+    long recordCount; // Number of whole record slots currently in the file
+    size_t recordsPerPage; // Records per buffer pool page
+
+    const char* mapBase; // Read-only mapping of the file, or nullptr
+    size_t mapBytes;     // Reserved length of the mapping (may exceed the file size)
+
+    void unmap() {
+#ifndef _WIN32
+        if (mapBase) munmap(const_cast<char*>(mapBase), mapBytes);
+#endif
+        mapBase = nullptr;
+        mapBytes = 0;
+    }
+
+    // (Re)maps the file with room to grow, so appends only force a remap once the
+    // file has doubled. Pages past EOF are never touched: reads are bounded by recordCount.
+    void remap() {
+        unmap();
+#ifndef _WIN32
+        size_t fileBytes = (size_t)recordCount * recordSize;
+        if (fileBytes == 0) return;
+        size_t want = max(fileBytes * 2, (size_t)1 << 20);
+        void* p = mmap(nullptr, want, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return; // Fall back to pread
+        mapBase = static_cast<const char*>(p);
+        mapBytes = want;
+#endif
+    }
+
+    // Pointer to [start, start + len) inside the mapping, remapping if the file outgrew it.
+    // Returns nullptr where there is no mapping; callers fall back to pread.
+    const char* mappedRange(size_t start, size_t len) {
+#ifdef _WIN32
+        (void)start;
+        (void)len;
+        return nullptr;
+#else
+        if (start + len > mapBytes) {
+            remap();
+            if (start + len > mapBytes) return nullptr;
+        }
+        return mapBase + start;
+#endif
+    }
+
+    // Returns the buffered page, reading it from the mapping (or pread) on a miss.
+    char* loadPage(long pageNo) {
+        if (char* page = recordBufferPool.find(fd, pageNo)) return page;
+
+        int64_t start = (int64_t)pageNo * (int64_t)recordsPerPage * (int64_t)recordSize;
+        int64_t fileBytes = (int64_t)recordCount * (int64_t)recordSize;
+        size_t pageBytes = recordsPerPage * recordSize;
+        size_t valid = (size_t)min<int64_t>((int64_t)pageBytes, max<int64_t>(0, fileBytes - start));
+
+        char* page = recordBufferPool.insert(fd, pageNo, pageBytes, start, valid);
+        const char* mapped = valid ? mappedRange((size_t)start, valid) : nullptr;
+        if (mapped) {
+            memcpy(page, mapped, valid);
+        } else if (valid && preadFully(fd, page, valid, start) != valid) {
+            recordBufferPool.discard(fd, pageNo); // Don't leave a zeroed page cached
+            throw runtime_error("Failed to read page " + to_string(pageNo) + " of " + path);
+        }
+        return page;
+    }
+
+    void ensureOpen() {
+        if (fd != -1) return;
+        fd = openDataFd(path);
+        if (fd == -1) throw runtime_error("Cannot open data file " + path);
+        int64_t bytes = dataFdSize(fd);
+        recordCount = bytes > 0 ? (long)(bytes / (int64_t)recordSize) : 0;
+    }
+
+public:
+    RecordFile(const string& filePath, size_t recSize)
+        : path(filePath), recordSize(recSize), fd(-1), recordCount(0),
+          recordsPerPage(max<size_t>(1, BUFFER_POOL_PAGE_BYTES / recSize)), mapBase(nullptr), mapBytes(0) {}
+
+    ~RecordFile() {
+        if (fd != -1) {
+            try { recordBufferPool.dropFile(fd); } catch (...) {}
+        }
+        unmap();
+        if (fd != -1) closeDataFd(fd);
+    }
+
+    RecordFile(const RecordFile&) = delete;
+    RecordFile& operator=(const RecordFile&) = delete;
+
+    // Appends a record at the end of the file and returns its slot number.
+    // Appends are written through; a cached copy of the tail page is kept in step.
+    long append(const void* rec) {
+        ensureOpen();
+        long pos = recordCount;
+        if (!pwriteFully(fd, rec, recordSize, (int64_t)pos * (int64_t)recordSize)) {
+            throw runtime_error("Failed to append record to " + path);
+        }
+        recordCount++;
+        if (char* page = recordBufferPool.peek(fd, pos / recordsPerPage)) {
+            size_t slot = (size_t)(pos % recordsPerPage);
+            memcpy(page + slot * recordSize, rec, recordSize);
+            recordBufferPool.extendValid(fd, pos / recordsPerPage, (slot + 1) * recordSize);
+        }
+        return pos;
+    }
+
+    // Appends count contiguous records with a single write and returns the first slot.
+    long appendMany(const void* recs, size_t count) {
+        ensureOpen();
+        long first = recordCount;
+        if (count == 0) return first;
+        if (!pwriteFully(fd, recs, count * recordSize, (int64_t)first * (int64_t)recordSize)) {
+            throw runtime_error("Failed to append records to " + path);
+        }
+        recordCount += (long)count;
+
+        // Only the old tail page can already be cached
+        long tailPage = first / (long)recordsPerPage;
+        if (char* page = recordBufferPool.peek(fd, tailPage)) {
+            size_t slot = (size_t)(first % (long)recordsPerPage);
+            size_t n = min(count, recordsPerPage - slot);
+            memcpy(page + slot * recordSize, recs, n * recordSize);
+            recordBufferPool.extendValid(fd, tailPage, (slot + n) * recordSize);
+        }
+        return first;
+    }
+
+    // Overwrites a record. The write goes straight to the file, so it reaches disk before
+    // the avail list or the index log can refer to it; a cached copy of the page is kept
+    // in step.
+    void write(long pos, const void* rec) {
+        ensureOpen();
+        if (pos < 0 || !pwriteFully(fd, rec, recordSize, (int64_t)pos * (int64_t)recordSize)) {
+            throw runtime_error("Failed to write record at position " + to_string(pos));
+        }
+        if (pos >= recordCount) recordCount = pos + 1;
+        if (char* page = recordBufferPool.peek(fd, pos / recordsPerPage)) {
+            size_t slot = (size_t)(pos % recordsPerPage);
+            memcpy(page + slot * recordSize, rec, recordSize);
+            recordBufferPool.extendValid(fd, pos / recordsPerPage, (slot + 1) * recordSize);
+        }
+    }
+
+    void read(long pos, void* rec) {
+        ensureOpen();
+        if (pos < 0 || pos >= recordCount) {
+            throw runtime_error("Failed to read record at position " + to_string(pos));
+        }
+        const char* page = loadPage(pos / recordsPerPage);
+        memcpy(rec, page + (size_t)(pos % recordsPerPage) * recordSize, recordSize);
+    }
+
+    // Reads many records at once. out receives positions.size() records in the order
+    // the positions were given. Positions are visited in file order, pages already in
+    // the buffer pool are copied from memory, and nearby missing pages are fetched with
+    // one large read per run. Out-of-range positions yield a zeroed record.
+    void readMany(const vector<long>& positions, void* out) {
+        ensureOpen();
+        char* dest = static_cast<char*>(out);
+        size_t n = positions.size();
+
+        vector<size_t> order;
+        order.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            if (positions[i] < 0 || positions[i] >= recordCount) {
+                memset(dest + i * recordSize, 0, recordSize);
+            } else {
+                order.push_back(i);
+            }
+        }
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) { return positions[a] < positions[b]; });
+
+        // Distinct pages in file order; touching each once keeps LRU order and counters honest.
+        vector<long> pages;
+        for (size_t i : order) {
+            long pageNo = positions[i] / (long)recordsPerPage;
+            if (pages.empty() || pages.back() != pageNo) pages.push_back(pageNo);
+        }
+        for (long pageNo : pages) recordBufferPool.find(fd, pageNo);
+
+        size_t pageBytes = recordsPerPage * recordSize;
+        int64_t fileBytes = (int64_t)recordCount * (int64_t)recordSize;
+        vector<char> scratch;
+        size_t next = 0; // Next entry of order to copy out
+
+        auto copyOut = [&](long pageNo, const char* page) {
+            while (next < order.size() && positions[order[next]] / (long)recordsPerPage == pageNo) {
+                size_t slot = (size_t)(positions[order[next]] % (long)recordsPerPage);
+                memcpy(dest + order[next] * recordSize, page + slot * recordSize, recordSize);
+                next++;
+            }
+        };
+
+        for (size_t p = 0; p < pages.size();) {
+            if (const char* cached = recordBufferPool.peek(fd, pages[p])) {
+                copyOut(pages[p], cached);
+                p++;
+                continue;
+            }
+
+            // Grow a run of nearby uncached pages and fetch it in one go.
+            size_t last = p;
+            while (last + 1 < pages.size()
+                   && pages[last + 1] - pages[last] <= BATCH_READ_MAX_GAP_PAGES
+                   && pages[last + 1] - pages[p] < BATCH_READ_MAX_RUN_PAGES
+                   && !recordBufferPool.peek(fd, pages[last + 1])) {
+                last++;
+            }
+            int64_t start = (int64_t)pages[p] * (int64_t)pageBytes;
+            size_t runBytes = (size_t)min<int64_t>((int64_t)(pages[last] - pages[p] + 1) * (int64_t)pageBytes,
+                                                   fileBytes - start);
+            const char* run = mappedRange((size_t)start, runBytes);
+            if (!run) {
+                scratch.resize(runBytes);
+                if (preadFully(fd, scratch.data(), runBytes, start) != runBytes) {
+                    throw runtime_error("Failed to read records from " + path);
+                }
+                run = scratch.data();
+            }
+
+            for (size_t q = p; q <= last; q++) {
+                size_t rel = (size_t)(pages[q] - pages[p]) * pageBytes;
+                size_t valid = min(pageBytes, runBytes - rel);
+                char* frame = recordBufferPool.insert(fd, pages[q], pageBytes, start + (int64_t)rel, valid);
+                memcpy(frame, run + rel, valid);
+                copyOut(pages[q], frame);
+            }
+            p = last + 1;
+        }
+    }
+
+    // Swaps a rewritten copy of the file (e.g. from compaction) in place of this one.
+    // The handle is closed and reopened lazily on the next access.
+    void replaceWith(const string& newPath) {
+        if (fd != -1) {
+            recordBufferPool.dropFile(fd);
+            unmap();
+            closeDataFd(fd);
+            fd = -1;
+        }
+        recordCount = 0;
+        filesystem::rename(newPath, path);
+    }
+
+    // Forces the records written so far to stable storage. Index changes that point at
+    // a record are logged only after this returns.
+    void sync() {
+        if (fd != -1 && !syncDataFd(fd)) throw runtime_error("Failed to sync " + path);
+    }
+
+    long size() {
+        ensureOpen();
+        return recordCount;
+    }
+
+    const string& filePath() const { return path; }
+    size_t recordBytes() const { return recordSize; }
+};
+
+// AVAIL LIST
+// Persistent stack of free record slots kept in a sidecar file next to the data
+// file ("<data file>.avail"). Each entry is a 64-bit slot number; push appends one
+// entry and pop truncates the last one, so both are O(1) and survive restarts.
+
+class AvailList {
+private:
+    string path;
+    int fd;
+    vector<int64_t> slots; // In-memory mirror of the sidecar, top of stack at the back
+
+    void ensureOpen() {
+        if (fd != -1) return;
+        fd = openDataFd(path);
+        if (fd == -1) throw runtime_error("Cannot open avail list " + path);
+        int64_t bytes = dataFdSize(fd);
+        size_t count = bytes > 0 ? (size_t)(bytes / (int64_t)sizeof(int64_t)) : 0;
+        slots.resize(count);
+        if (count > 0 && preadFully(fd, slots.data(), count * sizeof(int64_t), 0) != count * sizeof(int64_t)) {
+            slots.clear();
+        }
+    }
+
+public:
+    explicit AvailList(const string& dataFilePath) : path(dataFilePath + ".avail"), fd(-1) {}
+
+    ~AvailList() {
+        if (fd != -1) closeDataFd(fd);
+    }
+
+    AvailList(const AvailList&) = delete;
+    AvailList& operator=(const AvailList&) = delete;
+
+    void push(long slot) {
+        ensureOpen();
+        int64_t v = slot;
+        if (!pwriteFully(fd, &v, sizeof(v), (int64_t)slots.size() * (int64_t)sizeof(int64_t))) {
+            throw runtime_error("Failed to update avail list " + path);
+        }
+        slots.push_back(v);
+    }
+
+    // Returns a free slot number, or -1 if the list is empty.
+    long pop() {
+        ensureOpen();
+        if (slots.empty()) return -1;
+        long slot = (long)slots.back();
+        slots.pop_back();
+        truncateDataFd(fd, (int64_t)slots.size() * (int64_t)sizeof(int64_t));
+        return slot;
+    }
+
+    void clear() {
+        ensureOpen();
+        slots.clear();
+        truncateDataFd(fd, 0);
+    }
+
+    size_t size() {
+        ensureOpen();
+        return slots.size();
+    }
+};
+
+#endif
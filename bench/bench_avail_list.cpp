@@ -0,0 +1,60 @@
+// Slot reuse benchmark (user-003): deletes and re-adds every record for a number of
+// rounds, once appending every re-add (no avail list) and once reusing slots through
+// AvailList, then reports how large each data file grew.
+//
+// Usage: bench_avail_list [records] [rounds]   (default 1000 records, 50 rounds)
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "../RecordFile.h"
+
+using namespace std;
+
+const size_t RECORD_BYTES = 73; // sizeof(AppointmentRecord)
+
+static void run(const string& path, size_t n, size_t rounds, bool reuse) {
+    RecordFile file(path, RECORD_BYTES);
+    AvailList avail(path);
+    vector<char> rec(RECORD_BYTES, 'x');
+    vector<long> live(n);
+    for (size_t i = 0; i < n; i++) live[i] = file.append(rec.data());
+
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (long slot : live) {
+            file.write(slot, rec.data()); // Tombstone
+            if (reuse) avail.push(slot);
+        }
+        for (auto& slot : live) {
+            long free = reuse ? avail.pop() : -1;
+            if (free != -1) {
+                file.write(free, rec.data());
+                slot = free;
+            } else {
+                slot = file.append(rec.data());
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "  " << (reuse ? "avail list" : "append only") << ": " << file.size() << " records on disk ("
+         << filesystem::file_size(path) << " bytes), " << seconds << " s\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? stoul(argv[1]) : 1000;
+    size_t rounds = argc > 2 ? stoul(argv[2]) : 50;
+    filesystem::path dir = filesystem::temp_directory_path() / "bench_avail_list";
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+
+    cout << n << " live records, " << rounds << " rounds of delete-all + re-add\n";
+    run((dir / "append.dat").string(), n, rounds, false);
+    run((dir / "reuse.dat").string(), n, rounds, true);
+
+    filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Primary lookup benchmark (user-016): looks random 12-character appointment IDs up in
+// a sorted vector (classic binary search), OrderedIndex and the EytzingerIndex snapshot
+// built from it. Half of the probes are keys that are not in the index.
+//
+// Usage: bench_eytzinger [probes] [keys...]
+//   (default 5000000 probes against 100000, 1000000 and 10000000 keys)
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_set>
+
+#include "../IndexManagers.h"
+
+using namespace std;
+
+typedef ApptPrimaryIndexEntry Entry;
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 2n unique keys: the first n go in the index, the rest are misses.
+static vector<Entry> randomEntries(size_t n) {
+    mt19937_64 rng(42);
+    unordered_set<string> seen;
+    vector<Entry> entries;
+    entries.reserve(2 * n);
+    while (entries.size() < 2 * n) {
+        string id(12, 'A');
+        for (char& ch : id) ch = (char)('A' + rng() % 26);
+        if (seen.insert(id).second) entries.push_back({FixedKey(id), (long)entries.size()});
+    }
+    return entries;
+}
+
+static void report(const string& name, double seconds, size_t probes, long found, long expected) {
+    cout << "    " << name << ": " << (long)(seconds * 1e9 / (double)probes) << " ns/lookup"
+         << (found == expected ? "" : "  (MISMATCH)") << "\n";
+}
+
+static void run(size_t n, size_t probeCount) {
+    vector<Entry> entries = randomEntries(n);
+    vector<Entry> probes;
+    probes.reserve(probeCount);
+    mt19937_64 rng(7);
+    for (size_t i = 0; i < probeCount; i++) {
+        size_t pick = rng() % n;
+        probes.push_back(entries[i % 2 ? n + pick : pick]); // Odd probes miss
+    }
+
+    vector<Entry> sorted(entries.begin(), entries.begin() + n);
+    sort(sorted.begin(), sorted.end());
+    SortedVector<Entry> vec;
+    vec.assign(vector<Entry>(sorted));
+    OrderedIndex<Entry> tree;
+    tree.assign(vector<Entry>(sorted));
+    EytzingerIndex<Entry> snapshot;
+    snapshot.build(tree, [](const Entry& e) -> const FixedKey& { return e.appointmentId; });
+
+    long expected = (long)(probeCount - probeCount / 2);
+    cout << "  " << n << " keys, " << probeCount << " probes:\n";
+
+    auto start = chrono::steady_clock::now();
+    long found = 0;
+    for (const auto& p : probes) found += vec.find(p) >= 0;
+    report("binary search (SortedVector)", secondsSince(start), probeCount, found, expected);
+
+    start = chrono::steady_clock::now();
+    found = 0;
+    for (const auto& p : probes) found += tree.find(p) >= 0;
+    report("OrderedIndex", secondsSince(start), probeCount, found, expected);
+
+    start = chrono::steady_clock::now();
+    found = 0;
+    for (const auto& p : probes) found += snapshot.find(p.appointmentId) != nullptr;
+    report("EytzingerIndex", secondsSince(start), probeCount, found, expected);
+}
+
+int main(int argc, char** argv) {
+    size_t probes = argc > 1 ? stoul(argv[1]) : 5000000;
+    vector<size_t> sizes;
+    for (int i = 2; i < argc; i++) sizes.push_back(stoul(argv[i]));
+    if (sizes.empty()) sizes = {100000, 1000000, 10000000};
+
+    for (size_t n : sizes) run(n, probes);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Primary index store benchmark (user-011): inserts unique random 10-character
+// appointment IDs into OrderedIndex and SortedVector, looks every key up, then erases
+// most of them and looks the rest up again.
+//
+// Usage: bench_ordered_index [keys] [sorted vector keys]
+//   (default 1000000 keys; SortedVector is quadratic, so it gets 100000 by default)
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_set>
+
+#include "../IndexManagers.h"
+
+using namespace std;
+
+typedef ApptPrimaryIndexEntry Entry;
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static vector<Entry> randomEntries(size_t n) {
+    mt19937_64 rng(42);
+    unordered_set<string> seen;
+    vector<Entry> entries;
+    entries.reserve(n);
+    while (entries.size() < n) {
+        string id(10, 'A');
+        for (char& ch : id) ch = (char)('A' + rng() % 26);
+        if (seen.insert(id).second) entries.push_back({FixedKey(id), (long)entries.size()});
+    }
+    return entries;
+}
+
+template <class Store>
+static void run(const string& name, const vector<Entry>& entries) {
+    Store store;
+    auto start = chrono::steady_clock::now();
+    for (const auto& e : entries) store.insert(e);
+    double insertSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    long found = 0;
+    for (const auto& e : entries) found += store.find(e) >= 0;
+    double findSeconds = secondsSince(start);
+
+    // Erase 90% of the keys, then look the survivors up
+    size_t keep = entries.size() / 10;
+    start = chrono::steady_clock::now();
+    for (size_t i = keep; i < entries.size(); i++) store.erase(entries[i]);
+    double eraseSeconds = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < 10; round++) {
+        for (size_t i = 0; i < keep; i++) found += store.find(entries[i]) >= 0;
+    }
+    double afterSeconds = secondsSince(start);
+
+    cout << "  " << name << ", " << entries.size() << " keys: insert " << insertSeconds << " s, find all "
+         << findSeconds << " s, erase 90% " << eraseSeconds << " s, "
+         << (long)(afterSeconds * 1e9 / (double)max<size_t>(1, keep * 10)) << " ns/find after erase"
+         << (found == (long)(entries.size() + keep * 10) ? "" : "  (MISMATCH)") << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t vectorKeys = argc > 2 ? stoul(argv[2]) : 100000;
+
+    vector<Entry> entries = randomEntries(max(n, vectorKeys));
+    run<OrderedIndex<Entry>>("OrderedIndex", vector<Entry>(entries.begin(), entries.begin() + n));
+    run<SortedVector<Entry>>("SortedVector", vector<Entry>(entries.begin(), entries.begin() + vectorKeys));
+    return 0;
+}
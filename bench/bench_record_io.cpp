@@ -0,0 +1,77 @@
+// Record I/O benchmark (user-001): one fstream open/seek/close per record, as the
+// original appendRecord/readRecord did, against a long-lived RecordFile.
+//
+// Usage: bench_record_io [records]   (default 1000000)
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "../RecordFile.h"
+
+using namespace std;
+
+const size_t RECORD_BYTES = 73; // sizeof(AppointmentRecord)
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const string& what, size_t ops, double seconds) {
+    cout << "  " << what << ": " << (size_t)(ops / seconds) << " ops/s (" << seconds << " s)\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? stoul(argv[1]) : 1000000;
+    filesystem::path dir = filesystem::temp_directory_path() / "bench_record_io";
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    string fstreamPath = (dir / "fstream.dat").string();
+    string recordPath = (dir / "record.dat").string();
+
+    vector<char> rec(RECORD_BYTES, 'x');
+    vector<long> probes(n);
+    mt19937_64 rng(42);
+    for (auto& p : probes) p = (long)(rng() % n);
+
+    cout << n << " records of " << RECORD_BYTES << " bytes\n";
+
+    cout << "fstream per operation:\n";
+    {
+        ofstream(fstreamPath, ios::binary).close();
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            fstream file(fstreamPath, ios::in | ios::out | ios::binary);
+            file.seekp(0, ios::end);
+            file.write(rec.data(), RECORD_BYTES);
+        }
+        report("append", n, secondsSince(start));
+
+        start = chrono::steady_clock::now();
+        for (long p : probes) {
+            ifstream file(fstreamPath, ios::binary);
+            file.seekg(p * (long)RECORD_BYTES, ios::beg);
+            file.read(rec.data(), RECORD_BYTES);
+        }
+        report("random read", n, secondsSince(start));
+    }
+
+    cout << "RecordFile:\n";
+    {
+        RecordFile file(recordPath, RECORD_BYTES);
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) file.append(rec.data());
+        report("append", n, secondsSince(start));
+
+        start = chrono::steady_clock::now();
+        for (long p : probes) file.read(p, rec.data());
+        report("random read", n, secondsSince(start));
+    }
+
+    filesystem::remove_all(dir);
+    return 0;
+}
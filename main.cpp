@@ -1,14 +1,74 @@
 #include <iostream>
 #include <string>
 #include <limits>
+#include <cstdlib>
 #include "query.cpp"
 
 using namespace std;
 
 DoctorManager docMgr;
 
-int main() {
+// Runs a bulk CSV import into the "appointments" or "doctors" table.
+void importCsv(const string& table, const string& path) {
+    if (table == "appointments") {
+        AppointmentManager manager;
+        manager.importCsv(path);
+    } else if (table == "doctors") {
+        docMgr.importCsv(path);
+    } else {
+        cout << "Unsupported table: " << table << "\n";
+    }
+}
+
+// Vacuums both data files and rebuilds their indexes
+void compactDataFiles() {
+    AppointmentManager manager;
+    manager.compact();
+    docMgr.compact();
+}
+
+// Rebuilds the indexes of any data file whose compaction was interrupted by a crash
+void recoverCompaction() {
+    AppointmentManager manager;
+    manager.recoverCompaction();
+    docMgr.recoverCompaction();
+}
+
+int main(int argc, char* argv[]) {
+    // Non-interactive commands, e.g. --import appointments data.csv, --compact
+    vector<pair<string, string>> imports;
+    bool compact = false;
+    bool prefetch = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--buffer-pool-mb" && i + 1 < argc) {
+            recordBufferPool.setCapacityMB(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--import" && i + 2 < argc) {
+            imports.push_back({argv[i + 1], argv[i + 2]});
+            i += 2;
+        } else if (arg == "--compact") {
+            compact = true;
+        } else if (arg == "--prefetch-indexes") {
+            prefetch = true;
+        } else {
+            cout << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+    recoverCompaction();
+    if (!imports.empty() || compact) {
+        for (const auto& job : imports) {
+            importCsv(job.first, job.second);
+        }
+        if (compact) compactDataFiles();
+        return 0;
+    }
 
+    // Indexes load on first use; optionally warm them up while the menu waits for input
+    if (prefetch) {
+        apptIndexMgr.startPrefetch();
+        docIndexMgr.startPrefetch();
+    }
 
     bool running = true;
     while (running) {
@@ -22,7 +82,10 @@ int main() {
         cout << "7. Print Doctor Info (Doctor ID)\n";
         cout << "8. Print Appointment Info (Appointment ID)\n";
         cout << "9. Write Query\n";
-        cout << "10. Exit\n";
+        cout << "10. Show Storage Stats\n";
+        cout << "11. Bulk Import CSV\n";
+        cout << "12. Compact Data Files\n";
+        cout << "13. Exit\n";
         cout << "Choose an option: ";
 
         int choice = 0;
@@ -71,8 +134,9 @@ int main() {
                 getline(cin, appointmentTime);
                 
                 AppointmentManager manager;
-                manager.addAppointment(appointmentID, patientID, doctorID, date, appointmentTime);
-                cout << "Appointment added successfully.\n";
+                if (manager.addAppointment(appointmentID, patientID, doctorID, date, appointmentTime)) {
+                    cout << "Appointment added successfully.\n";
+                }
                 break;
             }
             case 3: {
@@ -167,11 +231,33 @@ int main() {
                 break;
             }
             case 10: {
+                recordBufferPool.printStats();
+                apptIndexMgr.printFilterStats("Appointment ID");
+                docIndexMgr.printFilterStats("Doctor ID");
+                break;
+            }
+            case 11: {
+                string table, path;
+
+                cout << "Enter table (appointments/doctors): ";
+                getline(cin, table);
+
+                cout << "Enter CSV file path: ";
+                getline(cin, path);
+
+                importCsv(table, path);
+                break;
+            }
+            case 12: {
+                compactDataFiles();
+                break;
+            }
+            case 13: {
                 running = false;
                 break;
             }
             default: {
-                cout << "Unknown option. Please choose a number from 1 to 10.\n";
+                cout << "Unknown option. Please choose a number from 1 to 13.\n";
                 break;
             }
         }
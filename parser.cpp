@@ -4,6 +4,15 @@
 
 using namespace std;
 
+// One "column = value", "column LIKE 'pattern'" or "column BETWEEN low AND high" term
+// of a WHERE clause
+struct WhereCondition {
+  string column;
+  string op; // "=", "like" or "between"
+  string value;
+  string valueTo; // Upper bound of "between"
+};
+
 class Parser {
 private:
   string trim(string source) {
@@ -59,35 +68,127 @@ private:
       whereClause.pop_back();
     }
 
-    // Find the '=' sign
-    size_t equalPos = whereClause.find('=');
-    if (equalPos == string::npos) {
-      throw invalid_argument("invalid WHERE clause format");
+    for (const string &condition : splitConditions(whereClause)) {
+      // Find the '=' sign or the LIKE / BETWEEN keyword, whichever comes first
+      string lower = toLower(condition);
+      size_t equalPos = condition.find('=');
+      string op = "=";
+      size_t opLength = 1;
+      for (const string keyword : {"like", "between"}) {
+        size_t pos = lower.find(" " + keyword + " ");
+        if (pos != string::npos && (equalPos == string::npos || pos < equalPos)) {
+          equalPos = pos;
+          op = keyword;
+          opLength = keyword.length() + 2;
+        }
+      }
+      if (equalPos == string::npos) {
+        throw invalid_argument("invalid WHERE clause format");
+      }
+
+      // Extract column name (lowercase)
+      string column = toLower(trim(condition.substr(0, equalPos)));
+      string value = trim(condition.substr(equalPos + opLength));
+      string valueTo;
+      if (op == "between") {
+        size_t andPos = betweenAnd(value);
+        if (andPos == string::npos) {
+          throw invalid_argument("BETWEEN needs two values joined by AND");
+        }
+        valueTo = unquote(trim(value.substr(andPos + 5)));
+        value = trim(value.substr(0, andPos));
+      }
+      this->conditions.push_back({column, op, unquote(value), valueTo});
     }
 
-    // Extract column name (lowercase)
-    this->searchColumnName = toLower(trim(whereClause.substr(0, equalPos)));
-    this->columnValue = trim(whereClause.substr(equalPos + 1));
+    // The first condition is also kept in searchColumnName / searchOperator / columnValue
+    this->searchColumnName = conditions.front().column;
+    this->searchOperator = conditions.front().op;
+    this->columnValue = conditions.front().value;
+  }
 
-    // Remove quotes from value
-    if (columnValue.length() >= 2 && columnValue.front() == '\'' &&
-        columnValue.back() == '\'') {
-      columnValue = columnValue.substr(1, columnValue.length() - 2);
+  // Removes the quotes around a value
+  string unquote(const string &value) {
+    if (value.length() >= 2 && value.front() == '\'' && value.back() == '\'') {
+      return value.substr(1, value.length() - 2);
+    }
+    return value;
+  }
+
+  // Position of the AND that joins the two values of a BETWEEN, outside quotes, or npos
+  size_t betweenAnd(const string &values) {
+    string lower = toLower(values);
+    bool quoted = false;
+    for (size_t i = 0; i < values.length(); i++) {
+      if (values[i] == '\'') {
+        quoted = !quoted;
+      } else if (!quoted && lower.compare(i, 5, " and ") == 0) {
+        return i;
+      }
+    }
+    return string::npos;
+  }
+
+  // Whether text starts with "column =", "column LIKE" or "column BETWEEN", i.e. a
+  // condition rather than more of a value
+  bool startsCondition(const string &text) {
+    size_t i = text.find_first_not_of(" ");
+    size_t end = i;
+    while (end < text.length() && (isalnum((unsigned char)text[end]) || text[end] == '_'))
+      end++;
+    if (i == string::npos || end == i)
+      return false;
+    end = text.find_first_not_of(" ", end);
+    if (end == string::npos)
+      return false;
+    return text[end] == '=' || toLower(text.substr(end, 5)) == "like " ||
+           toLower(text.substr(end, 8)) == "between ";
+  }
+
+  // Splits "a = 1 AND b = 2" on AND (any case) outside quoted values. An AND that is
+  // not followed by a condition stays part of the value (doctor_name = Ali and Sons),
+  // and the AND inside "BETWEEN low AND high" belongs to that condition.
+  vector<string> splitConditions(const string &whereClause) {
+    vector<string> parts;
+    string lower = toLower(whereClause);
+    bool quoted = false;
+    bool between = false; // Inside a BETWEEN whose AND has not been seen yet
+    size_t start = 0;
+    for (size_t i = 0; i < whereClause.length(); i++) {
+      if (whereClause[i] == '\'') {
+        quoted = !quoted;
+      } else if (!quoted && lower.compare(i, 9, " between ") == 0) {
+        between = true;
+      } else if (!quoted && between && lower.compare(i, 5, " and ") == 0) {
+        between = false;
+        i += 4;
+      } else if (!quoted && lower.compare(i, 5, " and ") == 0 &&
+                 startsCondition(whereClause.substr(i + 5))) {
+        parts.push_back(whereClause.substr(start, i - start));
+        start = i + 5;
+        i += 4;
+      }
     }
+    parts.push_back(whereClause.substr(start));
+    return parts;
   }
 
 public:
   vector<string> selectFields;
   string tableName;
   string searchColumnName;
+  string searchOperator;
   string columnValue;
+  vector<WhereCondition> conditions; // Joined by AND
   queue<string> stringQueue;
 
   void parse(string input) {
     this->selectFields.clear();
     this->tableName = "";
     this->searchColumnName = "";
+    this->searchOperator = "";
     this->columnValue = "";
+    this->conditions.clear();
     this->stringQueue = queue<string>();
     setQueue(input);
 
@@ -78,8 +78,40 @@ private:
       cout << "Error: WHERE clause is required for this query." << endl;
       return;
     }
+    if (parser.conditions.size() > 1) {
+      cout << "Unsupported WHERE clause: doctors take a single condition" << endl;
+      return;
+    }
+    if (parser.searchOperator == "between") {
+      cout << "Unsupported WHERE clause: BETWEEN is only supported on appointments.date" << endl;
+      return;
+    }
 
-    if (parser.searchColumnName == "doctor_name") {
+    if (parser.searchOperator == "like") {
+      // 'Ahm%' is a prefix search, a pattern without % a case-insensitive match, and
+      // '_' matches any one character
+      string pattern = parser.columnValue;
+      bool prefix = !pattern.empty() && pattern.back() == '%';
+      if (prefix) pattern.pop_back();
+      if (parser.searchColumnName != "doctor_name" || pattern.find('%') != string::npos) {
+        cout << "Unsupported LIKE: only doctor_name LIKE 'pattern' or 'pattern%' (_ for any one character) is supported" << endl;
+        return;
+      }
+      vector<DoctorRecord> records;
+      if (pattern.find('_') != string::npos) {
+        records = docMgr.getByDoctorNameLike(pattern, prefix);
+      } else {
+        records = prefix ? docMgr.getByDoctorNamePrefix(pattern) : docMgr.getByDoctorNameIgnoreCase(pattern);
+      }
+      if (records.empty()) {
+        cout << "No active records found for Doctor Name LIKE: "
+             << parser.columnValue << endl;
+      } else {
+        for (const auto &rec : records) {
+          cout << buildDoctorRecordString(rec) << endl;
+        }
+      }
+    } else if (parser.searchColumnName == "doctor_name") {
       vector<DoctorRecord> records =
           docMgr.getByDoctorName(parser.columnValue);
       if (records.empty()) {
@@ -112,8 +144,42 @@ private:
       cout << "Error: WHERE clause is required for this query." << endl;
       return;
     }
+    for (const auto &condition : parser.conditions) {
+      if (condition.op == "like") {
+        cout << "Unsupported WHERE clause: LIKE is only supported on doctors.doctor_name" << endl;
+        return;
+      }
+      if (condition.op == "between" && (condition.column != "date" || parser.conditions.size() > 1)) {
+        cout << "Unsupported WHERE clause: BETWEEN is only supported on date, on its own" << endl;
+        return;
+      }
+    }
 
-    if (parser.searchColumnName == "doctor_id") {
+    if (parser.conditions.size() > 1) {
+      // doctor_id = .. AND date = .. (either order) goes to the (doctor, date) index
+      string doctorId, date;
+      for (const auto &condition : parser.conditions) {
+        if (condition.column == "doctor_id" && doctorId.empty()) {
+          doctorId = condition.value;
+        } else if (condition.column == "date" && date.empty()) {
+          date = condition.value;
+        } else {
+          doctorId.clear();
+          break;
+        }
+      }
+      if (parser.conditions.size() != 2 || doctorId.empty() || date.empty()) {
+        cout << "Unsupported WHERE clause: only doctor_id = .. AND date = .. "
+                "can be combined"
+             << endl;
+        return;
+      }
+      vector<AppointmentRecord> records =
+          apptMgr.getByDoctorOnDate(doctorId, date);
+      for (const auto &rec : records) {
+        cout << buildRecordString(rec) << endl;
+      }
+    } else if (parser.searchColumnName == "doctor_id") {
       vector<AppointmentRecord> records =
           apptMgr.getByDoctorId(parser.columnValue);
       for (const auto &rec : records) {
@@ -128,6 +194,24 @@ private:
         cout << "No active record found for Appointment ID: "
              << parser.columnValue << endl;
       }
+    } else if (parser.searchColumnName == "patient_id") {
+      vector<AppointmentRecord> records =
+          apptMgr.getByPatientId(parser.columnValue);
+      for (const auto &rec : records) {
+        cout << buildRecordString(rec) << endl;
+      }
+    } else if (parser.searchOperator == "between") {
+      // Both ends inclusive, in date and time order
+      vector<AppointmentRecord> records =
+          apptMgr.getByDateRange(parser.columnValue, parser.conditions.front().valueTo);
+      for (const auto &rec : records) {
+        cout << buildRecordString(rec) << endl;
+      }
+    } else if (parser.searchColumnName == "date") {
+      vector<AppointmentRecord> records = apptMgr.getByDate(parser.columnValue);
+      for (const auto &rec : records) {
+        cout << buildRecordString(rec) << endl;
+      }
     } else {
       cout << "Unsupported WHERE column: " << parser.searchColumnName << endl;
     }
@@ -0,0 +1,120 @@
+#ifndef TEST_SESSION_H
+#define TEST_SESSION_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <csignal>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// PROGRAM SESSIONS FOR THE TESTS
+// Runs Ass1Files in a working directory with its stdin and stdout on pipes, so a test
+// can feed menu input, wait for replies and kill the process wherever it likes.
+
+struct Session {
+    pid_t pid = -1;
+    int in = -1;   // Child's stdin
+    int out = -1;  // Child's stdout
+    string output;
+};
+
+// env holds NAME=value settings added to the child's environment.
+inline Session startSession(const string& binary, const string& dir, const vector<string>& args = {},
+                            const vector<string>& env = {}) {
+    int toChild[2], fromChild[2];
+    if (pipe(toChild) != 0 || pipe(fromChild) != 0) throw runtime_error("pipe failed");
+    Session s;
+    s.pid = fork();
+    if (s.pid < 0) throw runtime_error("fork failed");
+    if (s.pid == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        close(toChild[0]); close(toChild[1]);
+        close(fromChild[0]); close(fromChild[1]);
+        if (chdir(dir.c_str()) != 0) _exit(127);
+        for (const auto& e : env) putenv(const_cast<char*>(e.c_str()));
+        vector<char*> argv{const_cast<char*>(binary.c_str())};
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(binary.c_str(), argv.data());
+        _exit(127);
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    s.in = toChild[1];
+    s.out = fromChild[0];
+    return s;
+}
+
+inline void send(Session& s, const string& input) {
+    size_t done = 0;
+    while (done < input.size()) {
+        ssize_t n = write(s.in, input.data() + done, input.size() - done);
+        if (n <= 0) throw runtime_error("write to child failed");
+        done += (size_t)n;
+    }
+}
+
+// Reads child output until it contains marker or the child closes stdout.
+inline bool readUntil(Session& s, const string& marker) {
+    char buf[4096];
+    while (s.output.find(marker) == string::npos) {
+        pollfd p{s.out, POLLIN, 0};
+        if (poll(&p, 1, 10000) <= 0) return false; // Ten seconds without output
+        ssize_t n = read(s.out, buf, sizeof(buf));
+        if (n <= 0) return false;
+        s.output.append(buf, (size_t)n);
+    }
+    return true;
+}
+
+// Kills the child first if crash is set; returns its exit status otherwise.
+inline int endSession(Session& s, bool crash) {
+    if (crash) kill(s.pid, SIGKILL);
+    if (s.in >= 0) close(s.in);
+    close(s.out);
+    int status;
+    waitpid(s.pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Runs one clean session: feeds input (which must end with the exit option) and
+// returns everything the program printed.
+inline string runClean(const string& binary, const string& dir, const string& input) {
+    Session s = startSession(binary, dir);
+    send(s, input);
+    readUntil(s, "Exiting.");
+    endSession(s, false);
+    return s.output;
+}
+
+// Runs the program non-interactively (e.g. --import) and returns its exit status;
+// output receives everything it printed.
+inline int runCommand(const string& binary, const string& dir, const vector<string>& args, string& output) {
+    Session s = startSession(binary, dir, args);
+    close(s.in);
+    s.in = -1;
+    char buf[4096];
+    pollfd p{s.out, POLLIN, 0};
+    ssize_t n;
+    while (poll(&p, 1, 60000) > 0 && (n = read(s.out, buf, sizeof(buf))) > 0) s.output.append(buf, (size_t)n);
+    output = s.output;
+    return endSession(s, false);
+}
+
+inline int failures = 0;
+
+inline void expect(const string& output, const string& text, bool present, const string& what) {
+    if ((output.find(text) != string::npos) != present) {
+        cout << "FAIL: " << what << " (" << (present ? "missing" : "unexpected") << " \"" << text << "\")\n";
+        failures++;
+    }
+}
+
+#endif //TEST_SESSION_H
@@ -0,0 +1,120 @@
+// Crash recovery test: drives the Ass1Files menu over a pipe, kills the process with
+// SIGKILL once a batch of mutations has been acknowledged, and checks that a restart
+// in the same directory sees every acknowledged record. The batch reuses deleted
+// slots, so a record write that is lost (or lands after the index change that points
+// at it) shows up as the wrong record under a live key.
+//
+// Usage: crash_recovery_test <path to Ass1Files>
+
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include <csignal>
+
+#include <unistd.h>
+
+#include "TestSession.h"
+
+using namespace std;
+
+// Kills the program right after a batch of mutations has been acknowledged; a restart
+// must see all of them.
+static void acknowledgedTest(const string& binary, const filesystem::path& dir) {
+    // Session 1: deletes free slot 0 of both data files and the next add reuses it.
+    // The doctor rename rewrites a record in place. Killed right after the last reply.
+    Session s = startSession(binary, dir.string());
+    send(s,
+         "1\nD1\nAlice\nCairo\n"
+         "1\nD2\nBob\nGiza\n"
+         "6\nD1\n"
+         "1\nD3\nCarol\nAlex\n"
+         "3\nD2\nRob\n"
+         "2\nA1\nP1\nD2\n2024-01-01\n10:00\n"
+         "2\nA2\nP2\nD2\n2024-01-02\n11:00\n"
+         "5\nA1\n"
+         "2\nA3\nP3\nD3\n2024-01-03\n12:00\n"
+         "8\nA3\n");
+    if (!readUntil(s, "Found A3: ")) {
+        cout << "FAIL: first session did not finish its mutations\n" << s.output;
+        endSession(s, true);
+        failures++;
+        return;
+    }
+    endSession(s, true);
+
+    // Session 2: everything acknowledged before the kill must be there.
+    string out = runClean(binary, dir.string(),
+                          "8\nA3\n8\nA2\n8\nA1\n"
+                          "7\nD3\n7\nD2\n7\nD1\n"
+                          "9\nSELECT all FROM appointments WHERE doctor_id = D3\n"
+                          "13\n");
+    int before = failures;
+    expect(out, "Found A3: AppointmentID: A3 | PatientID: P3 | DoctorID: D3", true, "reused appointment slot");
+    expect(out, "Found A2: AppointmentID: A2 | PatientID: P2", true, "untouched appointment");
+    expect(out, "Error: A1 not found.", true, "deleted appointment");
+    expect(out, "DoctorID: D3 | Name: Carol", true, "reused doctor slot");
+    expect(out, "DoctorID: D2 | Name: Rob", true, "renamed doctor");
+    expect(out, "DoctorID: D1", false, "deleted doctor");
+    expect(out, "AppointmentID: A1", false, "deleted appointment record");
+    if (failures != before) cout << "\n--- output after restart ---\n" << out;
+}
+
+// Runs input until the program kills itself at crash point, which it must reach.
+static void runUntilCrash(const string& binary, const filesystem::path& dir, const string& input,
+                          const string& point) {
+    Session s = startSession(binary, dir.string(), {}, {"ASS1_CRASH_AT=" + point});
+    send(s, input + "13\n");
+    readUntil(s, "Exiting.");
+    if (s.output.find("Exiting.") != string::npos) {
+        cout << "FAIL: the program never reached crash point " << point << "\n";
+        failures++;
+    }
+    endSession(s, false);
+}
+
+// Kills the program between logging the index deletes of a record and putting its slot
+// on the avail list. The next add must not hand the deleted ID the new record.
+static void deleteCrashTest(const string& binary, const filesystem::path& dir) {
+    runClean(binary, dir.string(),
+             "1\nD1\nAlice\nCairo\n"
+             "2\nA1\nP1\nD1\n2024-01-01\n10:00\n"
+             "2\nA2\nP2\nD1\n2024-01-02\n11:00\n"
+             "13\n");
+    runUntilCrash(binary, dir, "5\nA1\n", "delete-before-avail");
+    runUntilCrash(binary, dir, "6\nD1\n", "delete-before-avail");
+
+    string out = runClean(binary, dir.string(),
+                          "2\nA9\nP9\nD9\n2024-01-09\n09:00\n"
+                          "1\nD9\nZoe\nAswan\n"
+                          "8\nA1\n8\nA9\n8\nA2\n"
+                          "7\nD1\n7\nD9\n"
+                          "13\n");
+    int before = failures;
+    expect(out, "Error: A1 not found.", true, "appointment deleted before the crash");
+    expect(out, "Found A9: AppointmentID: A9 | PatientID: P9", true, "appointment added after the crash");
+    expect(out, "Found A2: AppointmentID: A2 | PatientID: P2", true, "untouched appointment");
+    expect(out, "DoctorID: D1 | Name", false, "doctor deleted before the crash");
+    expect(out, "DoctorID: D9 | Name: Zoe", true, "doctor added after the crash");
+    if (failures != before) cout << "\n--- output after restart ---\n" << out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: crash_recovery_test <path to Ass1Files>\n";
+        return 2;
+    }
+    string binary = filesystem::absolute(argv[1]).string();
+    filesystem::path dir = filesystem::temp_directory_path() / ("crash_recovery_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir / "acknowledged");
+    filesystem::create_directories(dir / "delete");
+    signal(SIGPIPE, SIG_IGN);
+
+    acknowledgedTest(binary, dir / "acknowledged");
+    deleteCrashTest(binary, dir / "delete");
+
+    filesystem::remove_all(dir);
+    if (failures) return 1;
+    cout << "crash recovery: ok\n";
+    return 0;
+}
@@ -0,0 +1,142 @@
+// Doctor scale test: imports more doctors than a short record slot can address, then
+// restarts the program and looks up doctors stored past slots 32,767 and 65,535 by ID
+// and by name. A second directory holds a doctor index in the first base format (short
+// slots) over an existing data file, which the program has to convert on first load.
+//
+// Usage: doctor_scale_test <path to Ass1Files>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+
+#include <unistd.h>
+
+#include "TestSession.h"
+#include "../IndexManagers.h"
+
+using namespace std;
+
+const int DOCTORS = 75000;
+
+static string doctorId(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "D%06d", i);
+    return buf;
+}
+
+// Print-doctor replies for each ID, one "7" option per ID.
+static string printDoctors(const vector<int>& ids) {
+    string input;
+    for (int i : ids) input += "7\n" + doctorId(i) + "\n";
+    return input;
+}
+
+static string doctorLine(int i) {
+    return "DoctorID: " + doctorId(i) + " | Name: Name" + to_string(i) + " |";
+}
+
+static void scaleTest(const string& binary, const filesystem::path& dir) {
+    {
+        ofstream csv(dir / "doctors.csv");
+        csv << "doctor_id,doctor_name,address\n";
+        for (int i = 0; i < DOCTORS; i++) csv << doctorId(i) << ",Name" << i << ",Street " << i << "\n";
+    }
+    string output;
+    if (runCommand(binary, dir.string(), {"--import", "doctors", "doctors.csv"}, output) != 0) {
+        cout << "FAIL: import exited with an error\n" << output;
+        failures++;
+        return;
+    }
+
+    // Slots 32,768 and 65,536 wrapped when doctor slots were short
+    string out = runClean(binary, dir.string(),
+                          printDoctors({0, 32767, 32768, 65535, 65536, DOCTORS - 1}) +
+                          "9\nSELECT all FROM doctors WHERE doctor_name = Name70000\n"
+                          "1\nD999999\nLate Doctor\nLast Street\n"
+                          "6\n" + doctorId(70001) + "\n"
+                          "13\n");
+    for (int i : {0, 32767, 32768, 65535, 65536, DOCTORS - 1}) {
+        expect(out, doctorLine(i), true, "imported doctor " + doctorId(i));
+    }
+    expect(out, "Doctor ID: " + doctorId(70000) + ", Name: Name70000", true, "name query past slot 65,535");
+
+    // The index changes above come back from the log; a doctor added past the import too
+    out = runClean(binary, dir.string(), printDoctors({40000, 70001, DOCTORS - 2}) + "7\nD999999\n13\n");
+    expect(out, doctorLine(40000), true, "doctor after restart");
+    expect(out, doctorLine(DOCTORS - 2), true, "high slot after restart");
+    expect(out, "DoctorID: " + doctorId(70001), false, "deleted doctor");
+    expect(out, "DoctorID: D999999 | Name: Late Doctor", true, "doctor added after the import");
+}
+
+// First base format: size_t count, then per entry a size_t key length, the key and a
+// short record slot. The secondary base of that format is not read (the index is
+// rebuilt from the records), so any file will do.
+static void writeLegacyBases(const filesystem::path& dir, const vector<pair<string, short>>& entries) {
+    ofstream p(dir / DOC_PRIMARY_INDEX_FILE, ios::binary);
+    size_t count = entries.size();
+    p.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& e : entries) {
+        size_t len = e.first.size();
+        p.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        p.write(e.first.data(), (streamsize)len);
+        p.write(reinterpret_cast<const char*>(&e.second), sizeof(e.second));
+    }
+    ofstream sec(dir / DOC_SECONDARY_INDEX_FILE, ios::binary);
+    size_t heads = 0;
+    sec.write(reinterpret_cast<const char*>(&heads), sizeof(heads));
+}
+
+static void legacyTest(const string& binary, const filesystem::path& dir) {
+    // The program writes the data file; only the indexes are swapped for old ones
+    runClean(binary, dir.string(), "1\nD3\nZed\nX\n1\nD1\nAmy\nY\n1\nD2\nBob\nZ\n13\n");
+    for (const auto& f : filesystem::directory_iterator(dir)) {
+        if (f.path().filename().string().rfind("doctor_", 0) == 0) filesystem::remove(f.path());
+    }
+    writeLegacyBases(dir, {{"D1", 1}, {"D2", 2}, {"D3", 0}});
+
+    string query = "7\nD1\n7\nD2\n7\nD3\n7\nD4\n"
+                   "9\nSELECT all FROM doctors WHERE doctor_name = Zed\n"
+                   "13\n";
+    for (int run = 0; run < 2; run++) { // Converted on the first run, read as v2 on the second
+        string what = run ? " after conversion" : " from the old format";
+        string out = runClean(binary, dir.string(), query);
+        expect(out, "DoctorID: D1 | Name: Amy", true, "D1" + what);
+        expect(out, "DoctorID: D2 | Name: Bob", true, "D2" + what);
+        expect(out, "DoctorID: D3 | Name: Zed", true, "D3" + what);
+        expect(out, "Doctor not found.", true, "missing doctor" + what);
+        expect(out, "Doctor ID: D3, Name: Zed", true, "name query" + what);
+    }
+
+    uint64_t magic = 0;
+    ifstream(dir / DOC_PRIMARY_INDEX_FILE, ios::binary).read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if (magic != PRIMARY_INDEX_V2_MAGIC) {
+        cout << "FAIL: the old primary base was not rewritten\n";
+        failures++;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: doctor_scale_test <path to Ass1Files>\n";
+        return 2;
+    }
+    string binary = filesystem::absolute(argv[1]).string();
+    filesystem::path dir = filesystem::temp_directory_path() / ("doctor_scale_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir / "scale");
+    filesystem::create_directories(dir / "legacy");
+    signal(SIGPIPE, SIG_IGN);
+
+    scaleTest(binary, dir / "scale");
+    legacyTest(binary, dir / "legacy");
+
+    filesystem::remove_all(dir);
+    if (failures) return 1;
+    cout << "doctor scale: ok\n";
+    return 0;
+}
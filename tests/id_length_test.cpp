@@ -0,0 +1,93 @@
+// ID length test: IDs are stored in 15-byte record fields and indexed as 16-byte keys.
+// An ID longer than that (here 17 bytes) must be rejected at the menu and at import,
+// not cut short: cut to 15 bytes it would collide with the ID made of its first 15.
+//
+// Usage: id_length_test <path to Ass1Files>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem>
+#include <csignal>
+
+#include <unistd.h>
+
+#include "TestSession.h"
+
+using namespace std;
+
+const string LONG_APPT = "A1234567890123456";  // 17 bytes
+const string SHORT_APPT = "A12345678901234";   // Its first 15 bytes
+const string LONG_DOC = "D1234567890123456";
+const string SHORT_DOC = "D12345678901234";
+
+static void menuTest(const string& binary, const filesystem::path& dir) {
+    string out = runClean(binary, dir.string(),
+                          "1\n" + LONG_DOC + "\nLong\nX\n"
+                          "1\n" + SHORT_DOC + "\nShort\nY\n"
+                          "2\n" + LONG_APPT + "\nP1\n" + SHORT_DOC + "\n2024-01-01\n10:00\n"
+                          "2\nA2\nP1\n" + LONG_DOC + "\n2024-01-01\n11:00\n"
+                          "2\n" + SHORT_APPT + "\nP1\n" + SHORT_DOC + "\n2024-01-02\n10:00\n"
+                          "13\n");
+    expect(out, "Error: Doctor ID " + LONG_DOC + " is longer than 15 characters.", true, "long doctor ID");
+    expect(out, "Error: Appointment ID " + LONG_APPT + " is longer than 15 characters.", true, "long appointment ID");
+    expect(out, "already exists", false, "15-byte IDs after a rejected 17-byte one");
+
+    out = runClean(binary, dir.string(),
+                   "7\n" + SHORT_DOC + "\n8\n" + SHORT_APPT + "\n8\nA2\n"
+                   "9\nSELECT all FROM appointments WHERE doctor_id = " + SHORT_DOC + "\n"
+                   "13\n");
+    expect(out, "DoctorID: " + SHORT_DOC + " | Name: Short", true, "15-byte doctor ID");
+    expect(out, "Found " + SHORT_APPT + ": AppointmentID: " + SHORT_APPT + " | PatientID: P1 | DoctorID: " + SHORT_DOC +
+                " | Date: 2024-01-02", true, "15-byte appointment ID");
+    expect(out, "Error: A2 not found.", true, "appointment with a long doctor ID");
+    expect(out, "2024-01-01", false, "rejected appointment under the cut ID");
+}
+
+static void importTest(const string& binary, const filesystem::path& dir) {
+    {
+        ofstream csv(dir / "appointments.csv");
+        csv << "appointment_id,patient_id,doctor_id,date,time\n"
+            << LONG_APPT << ",P1,D1,2024-01-01,10:00\n"
+            << "A2,P1," << LONG_DOC << ",2024-01-01,11:00\n"
+            << SHORT_APPT << ",P1,D1,2024-01-02,10:00\n";
+        ofstream docs(dir / "doctors.csv");
+        docs << "doctor_id,doctor_name,address\n"
+             << LONG_DOC << ",Long,X\n"
+             << SHORT_DOC << ",Short,Y\n";
+    }
+    string output;
+    runCommand(binary, dir.string(), {"--import", "appointments", "appointments.csv", "--import", "doctors", "doctors.csv"},
+               output);
+    expect(output, "Error: Appointment ID " + LONG_APPT + " is longer than 15 characters.", true, "long ID at import");
+    expect(output, "Error: Doctor ID " + LONG_DOC + " is longer than 15 characters.", true, "long doctor ID at import");
+    expect(output, "Imported 1 appointments (2 rows skipped)", true, "appointment import count");
+    expect(output, "Imported 1 doctors (1 rows skipped)", true, "doctor import count");
+
+    string out = runClean(binary, dir.string(), "8\n" + SHORT_APPT + "\n8\nA2\n7\n" + SHORT_DOC + "\n13\n");
+    expect(out, "Found " + SHORT_APPT + ": AppointmentID: " + SHORT_APPT + " | PatientID: P1 | DoctorID: D1 | Date: 2024-01-02",
+           true, "imported 15-byte appointment ID");
+    expect(out, "Error: A2 not found.", true, "imported row with a long doctor ID");
+    expect(out, "DoctorID: " + SHORT_DOC + " | Name: Short", true, "imported 15-byte doctor ID");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: id_length_test <path to Ass1Files>\n";
+        return 2;
+    }
+    string binary = filesystem::absolute(argv[1]).string();
+    filesystem::path dir = filesystem::temp_directory_path() / ("id_length_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir / "menu");
+    filesystem::create_directories(dir / "import");
+    signal(SIGPIPE, SIG_IGN);
+
+    menuTest(binary, dir / "menu");
+    importTest(binary, dir / "import");
+
+    filesystem::remove_all(dir);
+    if (failures) return 1;
+    cout << "id length: ok\n";
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Index allocation test: replaces the global operator new with a counter and checks
+// that searchByPrimary and searchBySecondary allocate nothing on a loaded index. The
+// primary lookups are counted while the search snapshot is current, after a write has
+// invalidated it (lookups go to the live store), and after a reopen (lookups go to the
+// on-disk tree). Half of the probes are missing keys and half are string_view slices.
+//
+// Usage: index_allocation_test
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <unistd.h>
+
+#include "../IndexManagers.h"
+
+using namespace std;
+
+// Only allocations made by the test thread while counting is set are counted, so
+// background checkpoints do not show up.
+static thread_local bool counting = false;
+static long allocations = 0;
+
+static void* allocate(size_t size) {
+    if (counting) allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+static void* allocateAligned(size_t size, align_val_t align) {
+    if (counting) allocations++;
+    size_t a = (size_t)align;
+    void* p = aligned_alloc(a, (size + a - 1) / a * a);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, align_val_t align) { return allocateAligned(size, align); }
+void* operator new[](size_t size, align_val_t align) { return allocateAligned(size, align); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete[](void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { free(p); }
+
+const size_t ENTRIES = 50000;
+const size_t DOCTORS = 500;
+const size_t PROBES = 4000; // Twice this stays below the lookups that rebuild an invalidated snapshot
+
+static int failures = 0;
+
+static void expect(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static string appointmentId(size_t i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "A%011zu", i);
+    return buf;
+}
+
+static string doctorId(size_t i) {
+    return "D" + to_string(i);
+}
+
+// Primary probes: even ones are stored IDs, odd ones are not. Every other probe is a
+// slice of one long string rather than a string of its own.
+struct Probes {
+    vector<string> owned;
+    string joined;
+    vector<string_view> views;
+
+    Probes() {
+        for (size_t i = 0; i < PROBES; i++) {
+            size_t n = (i * 7919) % ENTRIES;
+            owned.push_back(appointmentId(i % 2 ? ENTRIES + n : n));
+        }
+        for (const auto& id : owned) joined += id;
+        for (size_t i = 0; i < PROBES; i++) {
+            views.push_back(i % 4 < 2 ? string_view(owned[i]) : string_view(joined).substr(i * 12, 12));
+        }
+    }
+};
+
+static size_t searchPrimary(AppointmentIndexManager& mgr, const Probes& probes) {
+    size_t hits = 0;
+    for (string_view key : probes.views) {
+        const ApptPrimaryIndexEntry* e = mgr.searchByPrimary(key);
+        if (e && e->appointmentId.view() == key) hits++;
+    }
+    return hits;
+}
+
+// The keys are built inside the counted loop; they are short enough to stay inline.
+static size_t searchSecondary(AppointmentIndexManager& mgr, vector<long>& results) {
+    size_t slots = 0;
+    for (size_t d = 0; d < DOCTORS * 2; d++) { // The upper half are missing keys
+        mgr.searchBySecondary(doctorId(d % DOCTORS) + (d < DOCTORS ? "" : "X"), results);
+        slots += results.size();
+    }
+    return slots;
+}
+
+// Runs f once to warm caches, then again counting allocations.
+template <class F>
+static void countAllocations(F f, size_t expected, const string& what) {
+    expect(f() == expected, what + ": wrong results before counting");
+    allocations = 0;
+    counting = true;
+    size_t got = f();
+    counting = false;
+    expect(got == expected, what + ": wrong results");
+    expect(allocations == 0, what + ": " + to_string(allocations) + " allocations");
+}
+
+int main() {
+    filesystem::path dir = filesystem::temp_directory_path() / ("index_allocation_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    filesystem::current_path(dir);
+
+    Probes probes;
+    vector<long> results;
+    results.reserve(ENTRIES / DOCTORS);
+    {
+        AppointmentIndexManager mgr;
+        vector<ApptPrimaryIndexEntry> entries;
+        vector<string> doctors;
+        for (size_t i = 0; i < ENTRIES; i++) {
+            entries.push_back({FixedKey(appointmentId(i)), (long)i});
+            doctors.push_back(doctorId(i % DOCTORS));
+        }
+        mgr.bulkInsert(entries, doctors);
+
+        countAllocations([&]() { return searchPrimary(mgr, probes); }, PROBES / 2, "primary, snapshot");
+        countAllocations([&]() { return searchSecondary(mgr, results); }, ENTRIES, "secondary");
+
+        mgr.insertPrimary(appointmentId(2 * ENTRIES), 2 * ENTRIES);
+        countAllocations([&]() { return searchPrimary(mgr, probes); }, PROBES / 2, "primary, live store");
+        mgr.deletePrimary(appointmentId(2 * ENTRIES));
+    }
+    {
+        AppointmentIndexManager mgr;
+        countAllocations([&]() { return searchPrimary(mgr, probes); }, PROBES / 2, "primary, on-disk tree");
+        countAllocations([&]() { return searchSecondary(mgr, results); }, ENTRIES, "secondary, reopened");
+    }
+
+    filesystem::current_path(dir.parent_path());
+    filesystem::remove_all(dir);
+    if (failures) return 1;
+    cout << "index allocations: ok\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Query test: drives option 9 (Write Query) of the Ass1Files menu and checks which
+// records each WHERE clause returns (date ranges, LIKE patterns), in what order, and how
+// unsupported clauses are refused.
+//
+// Usage: query_test <path to Ass1Files>
+
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include <csignal>
+
+#include <unistd.h>
+
+#include "TestSession.h"
+
+using namespace std;
+
+// Output of one query, cut from the menu text around it
+static string runQuery(const string& binary, const filesystem::path& dir, const string& query) {
+    string out = runClean(binary, dir.string(), "9\n" + query + "\n13\n");
+    size_t start = out.find("Enter query: ");
+    size_t end = out.find("Main Menu", start);
+    if (start == string::npos) return out;
+    start += 13;
+    return out.substr(start, end == string::npos ? string::npos : end - start);
+}
+
+static void expectOrder(const string& output, const string& first, const string& second, const string& what) {
+    size_t a = output.find(first), b = output.find(second);
+    if (a == string::npos || b == string::npos || a > b) {
+        cout << "FAIL: " << what << " (\"" << first << "\" before \"" << second << "\")\n";
+        failures++;
+    }
+}
+
+static void dateRangeTest(const string& binary, const filesystem::path& dir) {
+    runClean(binary, dir.string(),
+             "2\nA1\nP1\nD1\n2024-01-01\n10:00\n"
+             "2\nA2\nP2\nD1\n2024-01-05\n09:00\n"
+             "2\nA3\nP1\nD2\n2024-01-03\n12:00\n"
+             "2\nA4\nP3\nD2\n2024-02-01\n08:00\n"
+             "2\nA5\nP1\nD1\n2024-01-03\n08:00\n"
+             "2\nA6\nP2\nD2\n2023-12-31\n23:00\n"
+             "5\nA5\n"
+             "13\n");
+
+    string out = runQuery(binary, dir, "SELECT appointment_id, date FROM appointments WHERE date BETWEEN 2024-01-01 AND 2024-01-05");
+    expect(out, "Appointment ID: A1, Date: 2024-01-01", true, "lower end of the range");
+    expect(out, "Appointment ID: A3, Date: 2024-01-03", true, "inside the range");
+    expect(out, "Appointment ID: A2, Date: 2024-01-05", true, "upper end of the range");
+    expect(out, "A4", false, "after the range");
+    expect(out, "A6", false, "before the range");
+    expect(out, "A5", false, "deleted appointment in the range");
+    expectOrder(out, "A1", "A3", "date order");
+    expectOrder(out, "A3", "A2", "date order");
+
+    out = runQuery(binary, dir, "select all from appointments where date between '2024-01-02' and '2024-01-31';");
+    expect(out, "Appointment ID: A3, Patient ID: P1, Doctor ID: D2, Date: 2024-01-03, Time: 12:00", true,
+           "quoted bounds, lower case keywords");
+    expect(out, "Appointment ID: A1", false, "quoted lower bound");
+
+    out = runQuery(binary, dir, "SELECT all FROM appointments WHERE date BETWEEN 2024-02-02 AND 2024-12-31");
+    expect(out, "Appointment ID", false, "empty range");
+
+    out = runQuery(binary, dir, "SELECT all FROM appointments WHERE date BETWEEN 2024-01-01");
+    expect(out, "Query Error: BETWEEN needs two values joined by AND", true, "BETWEEN without AND");
+
+    out = runQuery(binary, dir, "SELECT all FROM appointments WHERE date BETWEEN 2024-01-01 AND 2024-01-05 AND doctor_id = D1");
+    expect(out, "Unsupported WHERE clause: BETWEEN", true, "BETWEEN combined with another condition");
+
+    out = runQuery(binary, dir, "SELECT all FROM appointments WHERE doctor_id = D1 AND date = 2024-01-05");
+    expect(out, "Appointment ID: A2", true, "doctor and date still combine");
+}
+
+static void likeTest(const string& binary, const filesystem::path& dir) {
+    runClean(binary, dir.string(),
+             "1\nD1\nAhmed\nX\n"
+             "1\nD2\nAhmad\nX\n"
+             "1\nD3\nahmet\nX\n"
+             "1\nD4\nAhmedo\nX\n"
+             "1\nD5\nBob\nX\n"
+             "1\nD6\nAhmod\nX\n"
+             "6\nD6\n"
+             "13\n");
+
+    string out = runQuery(binary, dir, "SELECT doctor_id FROM doctors WHERE doctor_name LIKE 'Ahm_d'");
+    expect(out, "Doctor ID: D1", true, "'_' matches e");
+    expect(out, "Doctor ID: D2", true, "'_' matches a");
+    expect(out, "Doctor ID: D3", false, "letter after '_' still has to match");
+    expect(out, "Doctor ID: D4", false, "'_' is one character, not a prefix");
+    expect(out, "Doctor ID: D6", false, "deleted doctor");
+
+    out = runQuery(binary, dir, "SELECT doctor_id FROM doctors WHERE doctor_name LIKE 'ahm_d%'");
+    expect(out, "Doctor ID: D1", true, "'_' with a trailing %, ignoring case");
+    expect(out, "Doctor ID: D4", true, "trailing % after '_'");
+    expect(out, "Doctor ID: D3", false, "trailing % does not relax '_'");
+
+    out = runQuery(binary, dir, "SELECT doctor_id FROM doctors WHERE doctor_name LIKE '_ob'");
+    expect(out, "Doctor ID: D5", true, "leading '_'");
+
+    out = runQuery(binary, dir, "SELECT doctor_id FROM doctors WHERE doctor_name LIKE 'Ahm_'");
+    expect(out, "No active records found for Doctor Name LIKE: Ahm_", true, "'_' needs exactly one character");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: query_test <path to Ass1Files>\n";
+        return 2;
+    }
+    string binary = filesystem::absolute(argv[1]).string();
+    filesystem::path dir = filesystem::temp_directory_path() / ("query_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir / "dates");
+    filesystem::create_directories(dir / "like");
+    signal(SIGPIPE, SIG_IGN);
+
+    dateRangeTest(binary, dir / "dates");
+    likeTest(binary, dir / "like");
+
+    filesystem::remove_all(dir);
+    if (failures) return 1;
+    cout << "query: ok\n";
+    return 0;
+}